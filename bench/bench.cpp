@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "meta_model/flat_map.hpp"
+#include "meta_model/share_store.hpp"
+
+struct Item {
+    int uid;
+    int age { 18 };
+
+    bool operator==(const Item&) const = default;
+};
+
+template<>
+struct meta_model::ItemTrait<Item> {
+    using key_type   = int;
+    using store_type = meta_model::ShareStore<Item>;
+    static auto key(const Item& i) { return i.uid; }
+};
+
+namespace
+{
+// read by every loop, so none is optimized out
+std::size_t sink { 0 };
+
+// ns per op of fn doing n ops, best of some rounds
+template<typename F>
+auto measure(std::size_t n, F&& fn) -> double {
+    double best = std::numeric_limits<double>::max();
+    for (int round = 0; round < 5; round++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double, std::nano> took = std::chrono::steady_clock::now() - start;
+        best = std::min(best, took.count() / n);
+    }
+    return best;
+}
+
+void report(const char* group, const char* name, double ns) {
+    std::printf("%-20s %-24s %8.2f ns/op\n", group, name, ns);
+}
+
+template<typename Map>
+void bench_map(const char* group, const std::vector<int>& keys, const std::vector<int>& misses) {
+    auto n = keys.size();
+    report(group, "insert", measure(n, [&] {
+               Map map;
+               for (auto k : keys) map.try_emplace(k, k);
+               sink += map.size();
+           }));
+
+    Map map;
+    for (auto k : keys) map.try_emplace(k, k);
+    report(group, "find hit", measure(n, [&] {
+               for (auto k : keys) {
+                   if (auto it = map.find(k); it != map.end()) sink += it->second;
+               }
+           }));
+    report(group, "find miss", measure(n, [&] {
+               for (auto k : misses) sink += map.find(k) != map.end();
+           }));
+    report(group, "erase + insert", measure(2 * n, [&] {
+               for (auto k : keys) map.erase(k);
+               for (auto k : keys) map.try_emplace(k, k);
+           }));
+}
+
+void bench_store(const std::vector<int>& keys) {
+    using store_type = meta_model::ShareStore<Item>;
+    auto n           = keys.size();
+    report("ShareStore", "store_insert new", measure(n, [&] {
+               store_type                               store;
+               std::vector<store_type::store_item_type> held;
+               held.reserve(n);
+               for (auto k : keys) held.push_back(store.store_insert(Item { k }));
+               sink += store.size();
+           }));
+
+    store_type                               store;
+    std::vector<store_type::store_item_type> held;
+    held.reserve(n);
+    for (auto k : keys) held.push_back(store.store_insert(Item { k }));
+
+    report("ShareStore", "store_query", measure(n, [&] {
+               for (auto k : keys) sink += store.store_query(k)->age;
+           }));
+    report("ShareStore", "StoreItem deref", measure(n, [&] {
+               for (auto& item : held) sink += item->age;
+           }));
+    report("ShareStore", "store_insert same", measure(n, [&] {
+               for (auto k : keys) store.store_insert(Item { k });
+           }));
+    int age = 0;
+    report("ShareStore", "store_insert changed", measure(n, [&] {
+               ++age;
+               for (auto k : keys) store.store_insert(Item { k, age });
+               store.flush();
+           }));
+}
+} // namespace
+
+int main() {
+    constexpr int n = 100'000;
+
+    // shuffled even keys, odd ones miss
+    std::vector<int> keys, misses;
+    for (int i = 0; i < n; i++) {
+        keys.push_back(2 * i);
+        misses.push_back(2 * i + 1);
+    }
+    std::mt19937 gen(7);
+    std::ranges::shuffle(keys, gen);
+    std::ranges::shuffle(misses, gen);
+
+    bench_map<meta_model::detail::FlatMap<int, int>>("FlatMap", keys, misses);
+    bench_map<std::unordered_map<int, int>>("std::unordered_map", keys, misses);
+    bench_store(keys);
+    return sink == 0;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory_resource>
+
+#include "meta_model/item_trait.hpp"
+
+namespace meta_model
+{
+
+///
+/// @brief memory for a group of models and stores that die together
+/// a pool over a monotonic buffer: freed blocks are reused by the pool, and
+/// destroying the arena drops every block at once instead of one by one
+/// not thread safe, destroy the models and stores using it first
+class Arena {
+public:
+    explicit Arena(usize                      initial_size = 64 * 1024,
+                   std::pmr::memory_resource* upstream     = std::pmr::get_default_resource())
+        : m_buffer(initial_size, upstream), m_pool(&m_buffer) {}
+    Arena(const Arena&)            = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    auto resource() -> std::pmr::memory_resource* { return &m_pool; }
+
+    ///
+    /// @brief allocator for models (ModelType::allocator_type) and pmr stores
+    template<typename T = std::byte>
+    auto allocator() -> std::pmr::polymorphic_allocator<T> {
+        return std::pmr::polymorphic_allocator<T> { &m_pool };
+    }
+
+    ///
+    /// @brief free everything, nothing allocated from the arena may be alive
+    void release() {
+        m_pool.release();
+        m_buffer.release();
+    }
+
+private:
+    std::pmr::monotonic_buffer_resource    m_buffer;
+    std::pmr::unsynchronized_pool_resource m_pool;
+};
+
+} // namespace meta_model
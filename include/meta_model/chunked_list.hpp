@@ -0,0 +1,304 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "meta_model/item_trait.hpp"
+
+namespace meta_model
+{
+namespace detail
+{
+
+///
+/// @brief list of chunks of ChunkSize / 2 to 2 * ChunkSize rows
+/// positional insert/erase/move only shift the chunks at the ends of the range,
+/// rows are located through a fenwick tree of the chunk sizes in O(log n)
+template<typename T, typename Allocator = std::allocator<T>, usize ChunkSize = 512>
+class ChunkedList {
+    static_assert(ChunkSize > 1);
+
+    template<typename U>
+    using rebind_alloc = typename std::allocator_traits<Allocator>::template rebind_alloc<U>;
+    using chunk_type   = std::vector<T, Allocator>;
+
+    template<bool Const>
+    class Iter {
+        friend class ChunkedList;
+        using list_type = std::conditional_t<Const, const ChunkedList, ChunkedList>;
+
+        Iter(list_type* l, usize c, usize o): m_list(l), m_chunk(c), m_off(o) {}
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = std::conditional_t<Const, const T*, T*>;
+        using reference         = std::conditional_t<Const, const T&, T&>;
+
+        Iter(): m_list(nullptr), m_chunk(0), m_off(0) {}
+        template<bool C>
+            requires(Const && ! C)
+        Iter(const Iter<C>& o): m_list(o.m_list), m_chunk(o.m_chunk), m_off(o.m_off) {}
+
+        reference operator*() const { return m_list->m_chunks[m_chunk][m_off]; }
+        pointer   operator->() const { return std::addressof(**this); }
+
+        Iter& operator++() {
+            if (++m_off == m_list->m_chunks[m_chunk].size()) {
+                ++m_chunk;
+                m_off = 0;
+            }
+            return *this;
+        }
+        Iter operator++(int) {
+            auto out = *this;
+            ++*this;
+            return out;
+        }
+        Iter& operator--() {
+            if (m_off == 0) {
+                --m_chunk;
+                m_off = m_list->m_chunks[m_chunk].size();
+            }
+            --m_off;
+            return *this;
+        }
+        Iter operator--(int) {
+            auto out = *this;
+            --*this;
+            return out;
+        }
+        bool operator==(const Iter& o) const { return m_chunk == o.m_chunk && m_off == o.m_off; }
+
+    private:
+        friend class Iter<! Const>;
+        list_type* m_list;
+        usize      m_chunk;
+        usize      m_off;
+    };
+
+public:
+    using value_type     = T;
+    using allocator_type = Allocator;
+    using iterator       = Iter<false>;
+    using const_iterator = Iter<true>;
+
+    static constexpr usize chunk_size = ChunkSize;
+
+    ChunkedList(Allocator alloc = Allocator())
+        : m_alloc(alloc),
+          m_chunks(alloc),
+          m_tree(alloc),
+          m_size(0),
+          m_hint(npos),
+          m_hint_off(0) {}
+
+    auto get_allocator() const { return m_alloc; }
+
+    ///
+    /// @brief swap contents in O(1), allocators must compare equal
+    void swap(ChunkedList& o) noexcept {
+        m_chunks.swap(o.m_chunks);
+        m_tree.swap(o.m_tree);
+        std::swap(m_size, o.m_size);
+        std::swap(m_hint, o.m_hint);
+        std::swap(m_hint_off, o.m_hint_off);
+    }
+
+    auto size() const -> usize { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    auto begin() { return iterator { this, 0, 0 }; }
+    auto end() { return iterator { this, m_chunks.size(), 0 }; }
+    auto begin() const { return const_iterator { this, 0, 0 }; }
+    auto end() const { return const_iterator { this, m_chunks.size(), 0 }; }
+
+    const T& at(usize idx) const {
+        if (idx >= m_size) throw std::out_of_range("ChunkedList::at");
+        auto [c, off] = locate(idx);
+        return m_chunks[c][off];
+    }
+    T& at(usize idx) { return const_cast<T&>(std::as_const(*this).at(idx)); }
+
+    void clear() {
+        m_chunks.clear();
+        m_tree.clear();
+        m_size = 0;
+        m_hint = npos;
+    }
+
+    template<std::ranges::range U>
+    void insert(usize pos, U&& range) {
+        if (m_chunks.empty()) {
+            // not emplace, scoped allocators pass their own allocator
+            m_chunks.push_back(chunk_type(m_alloc));
+            rebuild();
+        }
+        auto [c, off] = pos == m_size ? std::pair { m_chunks.size() - 1, m_chunks.back().size() }
+                                      : locate(pos);
+        auto& chunk = m_chunks[c];
+        auto  old   = chunk.size();
+        for (auto&& el : std::forward<U>(range)) {
+            chunk.emplace_back(std::forward<decltype(el)>(el));
+        }
+        if (m_size == 0 && chunk.empty()) {
+            clear();
+            return;
+        }
+        std::rotate(chunk.begin() + off, chunk.begin() + old, chunk.end());
+        auto n = chunk.size() - old;
+        m_size += n;
+        m_hint = npos;
+        if (chunk.size() > 2 * ChunkSize) {
+            split(c);
+            rebuild();
+        } else {
+            add(c, n);
+        }
+    }
+
+    void erase(usize first, usize last) {
+        if (first >= last) return;
+        auto [c, first_off] = locate(first);
+        auto n              = last - first;
+        for (auto i = c; n > 0; i++) {
+            auto& chunk = m_chunks[i];
+            auto  off   = i == c ? first_off : 0;
+            auto  len   = std::min(n, chunk.size() - off);
+            chunk.erase(chunk.begin() + off, chunk.begin() + off + len);
+            add(i, -len);
+            n -= len;
+        }
+        m_size -= last - first;
+        m_hint = npos;
+        if (m_size == 0) {
+            clear();
+            return;
+        }
+
+        // only the chunks at both ends of the range can be left underfull
+        auto count       = m_chunks.size();
+        auto first_empty = std::remove_if(m_chunks.begin() + c, m_chunks.end(), [](auto& ch) {
+            return ch.empty();
+        });
+        m_chunks.erase(first_empty, m_chunks.end());
+        auto changed = m_chunks.size() != count;
+        changed |= rebalance(c + 1);
+        changed |= rebalance(c);
+        if (changed) rebuild();
+    }
+
+    ///
+    /// @brief same semantic as QAbstractItemModel::moveRows
+    void move(usize src, usize dst, usize count) {
+        if (count == 0 || src == dst) return;
+        chunk_type block(m_alloc);
+        block.reserve(count);
+        for (auto i = src; i < src + count; i++) {
+            block.emplace_back(std::move(at(i)));
+        }
+        erase(src, src + count);
+        insert(dst > src ? dst - count : dst,
+               std::ranges::subrange(std::make_move_iterator(block.begin()),
+                                     std::make_move_iterator(block.end())));
+    }
+
+    ///
+    /// @brief number of chunks, at most 2 * size / ChunkSize + 1
+    auto chunk_count() const -> usize { return m_chunks.size(); }
+
+private:
+    static constexpr usize npos = -1;
+
+    ///
+    /// @brief chunk holding row idx and the offset of the row in it
+    auto locate(usize idx) const -> std::pair<usize, usize> {
+        if (m_hint < m_chunks.size() && idx >= m_hint_off &&
+            idx < m_hint_off + m_chunks[m_hint].size()) {
+            return { m_hint, idx - m_hint_off };
+        }
+        // descend the fenwick tree of chunk sizes
+        usize c = 0, rest = idx;
+        for (auto step = std::bit_floor(m_chunks.size()); step > 0; step >>= 1) {
+            if (c + step <= m_chunks.size() && m_tree[c + step] <= rest) {
+                c += step;
+                rest -= m_tree[c];
+            }
+        }
+        m_hint     = c;
+        m_hint_off = idx - rest;
+        return { c, rest };
+    }
+
+    void add(usize c, usize delta) {
+        // unsigned wrap around subtracts
+        for (auto i = c + 1; i < m_tree.size(); i += i & -i) m_tree[i] += delta;
+    }
+
+    void rebuild() {
+        m_tree.assign(m_chunks.size() + 1, 0);
+        for (usize i = 1; i < m_tree.size(); i++) {
+            m_tree[i] += m_chunks[i - 1].size();
+            if (auto j = i + (i & -i); j < m_tree.size()) m_tree[j] += m_tree[i];
+        }
+    }
+
+    ///
+    /// @brief merge chunk c into a neighbour when under half a chunk
+    /// @return whether chunks changed
+    bool rebalance(usize c) {
+        if (c >= m_chunks.size() || m_chunks.size() < 2 || m_chunks[c].size() >= ChunkSize / 2) {
+            return false;
+        }
+        // into the smaller neighbour
+        auto left = c == m_chunks.size() - 1 ||
+                    (c > 0 && m_chunks[c - 1].size() <= m_chunks[c + 1].size());
+        auto a    = left ? c - 1 : c;
+        auto& next = m_chunks[a + 1];
+        std::move(next.begin(), next.end(), std::back_inserter(m_chunks[a]));
+        m_chunks.erase(m_chunks.begin() + a + 1);
+        if (m_chunks[a].size() > 2 * ChunkSize) split(a);
+        return true;
+    }
+
+    ///
+    /// @brief split chunk c in even pieces of about ChunkSize rows
+    void split(usize c) {
+        chunk_type rest(m_alloc);
+        std::swap(rest, m_chunks[c]);
+        auto pieces = (rest.size() + ChunkSize - 1) / ChunkSize;
+
+        std::vector<chunk_type, rebind_alloc<chunk_type>> out(m_alloc);
+        out.reserve(pieces);
+        usize beg = 0;
+        for (usize i = 0; i < pieces; i++) {
+            auto  end = rest.size() * (i + 1) / pieces;
+            auto& ch  = out.emplace_back(chunk_type(m_alloc));
+            ch.reserve(ChunkSize);
+            std::move(rest.begin() + beg, rest.begin() + end, std::back_inserter(ch));
+            beg = end;
+        }
+        m_chunks.erase(m_chunks.begin() + c);
+        m_chunks.insert(m_chunks.begin() + c,
+                        std::make_move_iterator(out.begin()),
+                        std::make_move_iterator(out.end()));
+    }
+
+    Allocator                                         m_alloc;
+    std::vector<chunk_type, rebind_alloc<chunk_type>> m_chunks;
+    // fenwick tree over chunk sizes, 1-based
+    std::vector<usize, rebind_alloc<usize>>           m_tree;
+    usize                                             m_size;
+    mutable usize                                     m_hint;
+    mutable usize                                     m_hint_off;
+};
+
+} // namespace detail
+} // namespace meta_model
@@ -0,0 +1,295 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "meta_model/share_store.hpp"
+
+namespace meta_model
+{
+
+///
+/// @brief ShareStore that accepts writes from any thread
+/// the owner thread (the one constructing the store) holds the item map and runs
+/// notifications; other threads append insert/increase/remove to sharded queues,
+/// which the owner applies in order in one queued flush
+/// reads never apply queued writes, so a view painting from store_query sees no
+/// change mid-paint; owner thread writes, store_item and sync apply them first
+/// store_query, store_item and notify registration are owner thread only
+template<typename T, typename Allocator = std::allocator<T>, usize Shards = 16>
+struct ConcurrentShareStore {
+    using local_type          = ShareStore<T, Allocator>;
+    using handle_type         = typename local_type::handle_type;
+    using key_type            = typename local_type::key_type;
+    using callback_type       = typename local_type::callback_type;
+    using field_callback_type = typename local_type::field_callback_type;
+    using store_item_type     = StoreItem<T, ConcurrentShareStore>;
+    using item_type           = T;
+
+    template<typename, typename>
+    friend class StoreItem;
+
+    struct Op {
+        enum class Type
+        {
+            Insert = 0,
+            Increase,
+            Remove,
+            Patch,
+            PatchFields
+        };
+        Type                    type;
+        key_type                key;
+        std::optional<T>        item;
+        bool                    new_one;
+        handle_type             handle;
+        std::function<void(T&)> patch {};
+        FieldMask               fields { 0 };
+    };
+
+    // written by any thread, so kept off the store allocator
+    struct Shard {
+        std::mutex      mutex;
+        std::vector<Op> ops;
+    };
+
+    struct Inner {
+        Inner(Allocator alloc)
+            : local(alloc),
+              owner(std::this_thread::get_id()),
+              flush_posted(false),
+              event(new QObject { nullptr }) {}
+        ~Inner() { delete event; }
+
+        local_type                local;
+        std::thread::id           owner;
+        std::array<Shard, Shards> shards;
+        std::atomic<bool>         flush_posted;
+        QObject*                  event;
+
+        auto shard(param_type<key_type> key) -> Shard& {
+            return shards[std::hash<key_type> {}(key) % Shards];
+        }
+
+        void push(Op op) {
+            {
+                auto&           s = shard(op.key);
+                std::lock_guard lock { s.mutex };
+                s.ops.push_back(std::move(op));
+            }
+            if (! flush_posted.exchange(true, std::memory_order_acq_rel)) {
+                QMetaObject::invokeMethod(
+                    event,
+                    [this, p = QPointer(event)] {
+                        if (! p) return;
+                        drain();
+                        local.flush();
+                    },
+                    Qt::QueuedConnection);
+            }
+        }
+
+        void drain() {
+            flush_posted.store(false, std::memory_order_release);
+            std::vector<Op> ops;
+            for (auto& s : shards) {
+                {
+                    std::lock_guard lock { s.mutex };
+                    std::swap(ops, s.ops);
+                }
+                for (auto& op : ops) apply(op);
+                ops.clear();
+            }
+        }
+
+        void apply(Op& op) {
+            switch (op.type) {
+            case Op::Type::Insert: insert(std::move(*op.item), op.new_one, op.handle); break;
+            case Op::Type::Increase: local.store_increase(op.key); break;
+            case Op::Type::Remove: local.store_remove(op.key, op.handle); break;
+            case Op::Type::Patch:
+                local.store_patch(op.key, op.patch, op.fields, op.handle);
+                break;
+            case Op::Type::PatchFields:
+                if constexpr (role_readable_item<T>) {
+                    local.store_patch(op.key, *op.item, op.fields, op.handle);
+                }
+                break;
+            }
+        }
+
+        // leaves one count for the caller's store item
+        template<typename V>
+        void insert(V&& item, bool new_one, handle_type handle) {
+            auto key = ItemTrait<T>::key(item);
+            auto tmp = local.store_insert(std::forward<V>(item), new_one, handle);
+            local.store_increase(key);
+        }
+
+        bool on_owner() const { return std::this_thread::get_id() == owner; }
+
+        // owner thread, writes staged before this call must be visible
+        void sync() {
+            if (flush_posted.load(std::memory_order_acquire)) drain();
+        }
+    };
+
+    Arc<Inner> inner;
+
+    ConcurrentShareStore(Allocator alloc = Allocator {})
+        : inner(Arc<Inner>::create(new Inner(alloc))) {}
+
+    constexpr bool operator==(const ConcurrentShareStore& o) const { return inner == o.inner; }
+
+    Allocator get_allocator() { return inner->local.get_allocator(); }
+
+    auto store_query(param_type<key_type> k) const -> T* {
+        Q_ASSERT(inner->on_owner());
+        return inner->local.store_query(k);
+    }
+
+    auto store_insert(const T& item, bool new_one = false, handle_type handle = 0)
+        -> store_item_type {
+        return insert_impl(item, new_one, handle);
+    }
+    auto store_insert(T&& item, bool new_one = false, handle_type handle = 0)
+        -> store_item_type {
+        return insert_impl(std::move(item), new_one, handle);
+    }
+
+    auto store_item(param_type<key_type> k) -> std::optional<store_item_type> {
+        Q_ASSERT(inner->on_owner());
+        inner->sync();
+        // local applies retention and stats, its count is taken over
+        auto item = inner->local.store_item(k);
+        if (! item) return std::nullopt;
+        item->m_key = {};
+        return store_item_type { *this, k };
+    }
+
+    void store_increase(param_type<key_type> k) {
+        if (inner->on_owner()) {
+            inner->sync();
+            inner->local.store_increase(k);
+        } else {
+            inner->push(Op { Op::Type::Increase, k, std::nullopt, false, 0 });
+        }
+    }
+
+    void store_remove(param_type<key_type> k, handle_type handle = 0) {
+        if (inner->on_owner()) {
+            inner->sync();
+            inner->local.store_remove(k, handle);
+        } else {
+            inner->push(Op { Op::Type::Remove, k, std::nullopt, false, handle });
+        }
+    }
+
+    template<typename F>
+        requires std::invocable<F, T&>
+    void store_patch(param_type<key_type> k, F&& fn, FieldMask touched, handle_type handle = 0) {
+        if (inner->on_owner()) {
+            inner->sync();
+            inner->local.store_patch(k, std::forward<F>(fn), touched, handle);
+        } else {
+            inner->push(Op { Op::Type::Patch,
+                             k,
+                             std::nullopt,
+                             false,
+                             handle,
+                             std::forward<F>(fn),
+                             touched });
+        }
+    }
+    void store_patch(param_type<key_type> k, const T& patch, FieldMask mask,
+                     handle_type handle = 0)
+        requires role_readable_item<T>
+    {
+        if (inner->on_owner()) {
+            inner->sync();
+            inner->local.store_patch(k, patch, mask, handle);
+        } else {
+            inner->push(Op { Op::Type::PatchFields, k, patch, false, handle, {}, mask });
+        }
+    }
+
+    auto store_generation() const -> std::uint64_t {
+        Q_ASSERT(inner->on_owner());
+        return inner->local.store_generation();
+    }
+
+    void store_resubscribe(param_type<key_type> k, handle_type from, handle_type to) {
+        Q_ASSERT(inner->on_owner());
+        inner->sync();
+        inner->local.store_resubscribe(k, from, to);
+    }
+
+    auto store_reg_notify(callback_type cb, bool filtered = false) -> handle_type {
+        Q_ASSERT(inner->on_owner());
+        return inner->local.store_reg_notify(std::move(cb), filtered);
+    }
+    auto store_reg_notify(field_callback_type cb, bool filtered = false) -> handle_type {
+        Q_ASSERT(inner->on_owner());
+        return inner->local.store_reg_notify(std::move(cb), filtered);
+    }
+    void store_unreg_notify(handle_type handle) {
+        Q_ASSERT(inner->on_owner());
+        inner->local.store_unreg_notify(handle);
+    }
+
+    void set_retention(const StoreRetention& retention) {
+        Q_ASSERT(inner->on_owner());
+        inner->sync();
+        inner->local.set_retention(retention);
+    }
+    auto retention_stats() const -> const StoreRetentionStats& {
+        Q_ASSERT(inner->on_owner());
+        return inner->local.retention_stats();
+    }
+
+    auto suppressed_updates() const -> usize {
+        Q_ASSERT(inner->on_owner());
+        return inner->local.suppressed_updates();
+    }
+
+    ///
+    /// @brief apply queued writes, notify on the next event loop turn, owner thread only
+    /// e.g. before reading rows whose store items were handed over by another thread
+    void sync() {
+        Q_ASSERT(inner->on_owner());
+        inner->sync();
+    }
+
+    ///
+    /// @brief apply queued writes and notify now, owner thread only
+    void flush() {
+        Q_ASSERT(inner->on_owner());
+        inner->drain();
+        inner->local.flush();
+    }
+
+    auto size() const -> std::size_t {
+        Q_ASSERT(inner->on_owner());
+        return inner->local.size();
+    }
+
+private:
+    template<typename V>
+    auto insert_impl(V&& item, bool new_one, handle_type handle) -> store_item_type {
+        auto key = ItemTrait<T>::key(item);
+        if (inner->on_owner()) {
+            inner->sync();
+            inner->insert(std::forward<V>(item), new_one, handle);
+        } else {
+            inner->push(Op { Op::Type::Insert, key, std::forward<V>(item), new_one, handle });
+        }
+        return { *this, key };
+    }
+};
+
+} // namespace meta_model
@@ -0,0 +1,412 @@
+#pragma once
+
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include "meta_model/item_trait.hpp"
+
+namespace meta_model
+{
+namespace detail
+{
+
+///
+/// @brief open-addressing hash map, swiss table layout without simd
+/// one control byte per slot holds 7 bits of the hash, probed 8 slots at a time,
+/// so most misses never touch the slots
+/// values move on rehash, any insert may invalidate pointers and references
+template<typename K, typename V, typename Hash = std::hash<K>, typename Eq = std::equal_to<K>,
+         typename Allocator = std::allocator<std::pair<const K, V>>>
+class FlatMap {
+public:
+    using key_type       = K;
+    using mapped_type    = V;
+    using value_type     = std::pair<const K, V>;
+    using allocator_type = Allocator;
+    using size_type      = usize;
+
+private:
+    template<typename U>
+    using rebind_alloc = typename std::allocator_traits<Allocator>::template rebind_alloc<U>;
+    using ctrl_t       = std::uint8_t;
+    using slot_type    = value_type;
+    using ctrl_alloc   = rebind_alloc<ctrl_t>;
+    using slot_alloc   = rebind_alloc<slot_type>;
+    using ctrl_trait   = std::allocator_traits<ctrl_alloc>;
+    using slot_trait   = std::allocator_traits<slot_alloc>;
+
+    static constexpr ctrl_t        empty_ctrl   = 0x80;
+    static constexpr ctrl_t        deleted_ctrl = 0xfe;
+    static constexpr usize         group_size   = 8;
+    static constexpr std::uint64_t lsbs         = 0x0101010101010101ull;
+    static constexpr std::uint64_t msbs         = 0x8080808080808080ull;
+
+    // bit 7 of each matching byte
+    struct Group {
+        std::uint64_t word;
+
+        explicit Group(const ctrl_t* p) { std::memcpy(&word, p, sizeof(word)); }
+
+        // may report a false match right after a true one, keys are compared anyway
+        auto match(ctrl_t h2) const -> std::uint64_t {
+            auto x = word ^ (lsbs * h2);
+            return (x - lsbs) & ~x & msbs;
+        }
+        auto match_empty() const -> std::uint64_t { return word & ~(word << 6) & msbs; }
+        auto match_free() const -> std::uint64_t { return word & ~(word << 7) & msbs; }
+    };
+
+    static auto next_bit(std::uint64_t& mask) -> usize {
+        auto i = std::countr_zero(mask) / 8;
+        mask &= mask - 1;
+        return i;
+    }
+
+    template<bool Const>
+    class Iter {
+        friend class FlatMap;
+        using map_type = std::conditional_t<Const, const FlatMap, FlatMap>;
+
+        Iter(map_type* m, usize i): m_map(m), m_idx(i) { skip(); }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = FlatMap::value_type;
+        using difference_type   = std::ptrdiff_t;
+        using pointer   = std::conditional_t<Const, const value_type*, value_type*>;
+        using reference = std::conditional_t<Const, const value_type&, value_type&>;
+
+        Iter(): m_map(nullptr), m_idx(0) {}
+        template<bool C>
+            requires(Const && ! C)
+        Iter(const Iter<C>& o): m_map(o.m_map), m_idx(o.m_idx) {}
+
+        reference operator*() const { return m_map->value_at(m_idx); }
+        pointer   operator->() const { return std::addressof(**this); }
+
+        Iter& operator++() {
+            ++m_idx;
+            skip();
+            return *this;
+        }
+        Iter operator++(int) {
+            auto out = *this;
+            ++*this;
+            return out;
+        }
+        bool operator==(const Iter& o) const { return m_idx == o.m_idx; }
+
+    private:
+        friend class Iter<! Const>;
+        void skip() {
+            while (m_idx < m_map->m_capacity && ! is_full(m_map->m_ctrl[m_idx])) ++m_idx;
+        }
+
+        map_type* m_map;
+        usize     m_idx;
+    };
+
+public:
+    using iterator       = Iter<false>;
+    using const_iterator = Iter<true>;
+
+    FlatMap(Allocator alloc = Allocator())
+        : m_alloc(alloc),
+          m_ctrl(nullptr),
+          m_slots(nullptr),
+          m_capacity(0),
+          m_size(0),
+          m_growth_left(0) {}
+    ~FlatMap() { release(); }
+
+    FlatMap(const FlatMap& o): FlatMap(o.m_alloc) {
+        reserve(o.m_size);
+        for (auto& el : o) insert(el);
+    }
+    FlatMap(FlatMap&& o) noexcept
+        : m_alloc(o.m_alloc),
+          m_ctrl(std::exchange(o.m_ctrl, nullptr)),
+          m_slots(std::exchange(o.m_slots, nullptr)),
+          m_capacity(std::exchange(o.m_capacity, 0)),
+          m_size(std::exchange(o.m_size, 0)),
+          m_growth_left(std::exchange(o.m_growth_left, 0)) {}
+    FlatMap& operator=(const FlatMap& o) {
+        if (this != &o) {
+            clear();
+            reserve(o.m_size);
+            for (auto& el : o) insert(el);
+        }
+        return *this;
+    }
+    FlatMap& operator=(FlatMap&& o) noexcept(
+        std::allocator_traits<Allocator>::is_always_equal::value ||
+        std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value) {
+        if (this == &o) return *this;
+        if constexpr (! std::allocator_traits<
+                          Allocator>::propagate_on_container_move_assignment::value) {
+            // memory of another resource can't be freed by ours
+            if (! (m_alloc == o.m_alloc)) {
+                clear();
+                reserve(o.m_size);
+                for (auto& el : o) try_emplace(el.first, std::move(el.second));
+                o.clear();
+                return *this;
+            }
+        }
+        release();
+        if constexpr (std::allocator_traits<
+                          Allocator>::propagate_on_container_move_assignment::value) {
+            m_alloc = o.m_alloc;
+        }
+        m_ctrl        = std::exchange(o.m_ctrl, nullptr);
+        m_slots       = std::exchange(o.m_slots, nullptr);
+        m_capacity    = std::exchange(o.m_capacity, 0);
+        m_size        = std::exchange(o.m_size, 0);
+        m_growth_left = std::exchange(o.m_growth_left, 0);
+        return *this;
+    }
+
+    auto get_allocator() const -> Allocator { return m_alloc; }
+    auto size() const -> usize { return m_size; }
+    bool empty() const { return m_size == 0; }
+    auto capacity() const -> usize { return m_capacity; }
+
+    auto begin() { return iterator { this, 0 }; }
+    auto end() { return iterator { this, m_capacity }; }
+    auto begin() const { return const_iterator { this, 0 }; }
+    auto end() const { return const_iterator { this, m_capacity }; }
+
+    auto find(param_type<K> key) -> iterator { return iterator { this, find_index(key) }; }
+    auto find(param_type<K> key) const -> const_iterator {
+        return const_iterator { this, find_index(key) };
+    }
+    bool contains(param_type<K> key) const { return find_index(key) != m_capacity; }
+
+    template<typename... Args>
+    auto try_emplace(param_type<K> key, Args&&... args) -> std::pair<iterator, bool> {
+        auto [idx, found] = prepare_insert(key);
+        if (! found) {
+            construct_at(idx,
+                         std::piecewise_construct,
+                         std::forward_as_tuple(key),
+                         std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+        return { iterator { this, idx }, ! found };
+    }
+
+    auto insert(const value_type& v) -> std::pair<iterator, bool> {
+        return try_emplace(v.first, v.second);
+    }
+    auto insert(value_type&& v) -> std::pair<iterator, bool> {
+        return try_emplace(v.first, std::move(v.second));
+    }
+    template<typename P>
+        requires std::constructible_from<value_type, P&&>
+    auto insert(P&& p) -> std::pair<iterator, bool> {
+        if constexpr (std::is_rvalue_reference_v<P&&>) {
+            return try_emplace(p.first, std::move(p.second));
+        } else {
+            return try_emplace(p.first, p.second);
+        }
+    }
+
+    template<typename M>
+    auto insert_or_assign(param_type<K> key, M&& v) -> std::pair<iterator, bool> {
+        auto [it, ok] = try_emplace(key, std::forward<M>(v));
+        if (! ok) it->second = std::forward<M>(v);
+        return { it, ok };
+    }
+
+    auto erase(param_type<K> key) -> usize {
+        auto idx = find_index(key);
+        if (idx == m_capacity) return 0;
+        erase_at(idx);
+        return 1;
+    }
+    auto erase(const_iterator it) -> iterator {
+        erase_at(it.m_idx);
+        return iterator { this, it.m_idx + 1 };
+    }
+    auto erase(iterator it) -> iterator { return erase(const_iterator { it }); }
+
+    void clear() {
+        for (usize i = 0; i < m_capacity; i++) {
+            if (is_full(m_ctrl[i])) destroy_at(i);
+        }
+        if (m_capacity) std::memset(m_ctrl, empty_ctrl, m_capacity);
+        m_size        = 0;
+        m_growth_left = max_load(m_capacity);
+    }
+
+    void reserve(usize n) {
+        if (n <= m_size + m_growth_left) return;
+        usize cap = group_size;
+        while (max_load(cap) < n) cap *= 2;
+        rehash(cap);
+    }
+
+private:
+    static bool is_full(ctrl_t c) { return (c & 0x80) == 0; }
+    static auto max_load(usize cap) -> usize { return cap - cap / 8; }
+
+    // identity hashes of integers would put everything in one group
+    auto hash_of(param_type<K> key) const -> std::uint64_t {
+        auto h = static_cast<std::uint64_t>(Hash {}(key)) * 0x9e3779b97f4a7c15ull;
+        return h ^ (h >> 32);
+    }
+    auto groups() const -> usize { return m_capacity / group_size; }
+
+    value_type& value_at(usize idx) const { return m_slots[idx]; }
+
+    auto find_index(param_type<K> key) const -> usize {
+        if (m_size == 0) return m_capacity;
+        auto   h    = hash_of(key);
+        ctrl_t h2   = h & 0x7f;
+        usize  mask = groups() - 1;
+        usize  g    = (h >> 7) & mask;
+        for (usize step = 1;; step++) {
+            Group grp { m_ctrl + g * group_size };
+            for (auto m = grp.match(h2); m;) {
+                auto idx = g * group_size + next_bit(m);
+                if (Eq {}(value_at(idx).first, key)) return idx;
+            }
+            if (grp.match_empty()) return m_capacity;
+            g = (g + step) & mask;
+        }
+    }
+
+    // slot of key, or a free slot with its control byte set
+    auto prepare_insert(param_type<K> key) -> std::pair<usize, bool> {
+        if (auto idx = find_index(key); idx != m_capacity) return { idx, true };
+        if (m_growth_left == 0) {
+            // drop tombstones in place when they fill most of the table
+            rehash(m_size * 2 >= max_load(m_capacity) || m_capacity == 0
+                       ? std::max(group_size, m_capacity * 2)
+                       : m_capacity);
+        }
+        auto   h    = hash_of(key);
+        ctrl_t h2   = h & 0x7f;
+        usize  mask = groups() - 1;
+        usize  g    = (h >> 7) & mask;
+        for (usize step = 1;; step++) {
+            Group grp { m_ctrl + g * group_size };
+            if (auto m = grp.match_free()) {
+                auto idx = g * group_size + next_bit(m);
+                if (m_ctrl[idx] == empty_ctrl) --m_growth_left;
+                m_ctrl[idx] = h2;
+                return { idx, false };
+            }
+            g = (g + step) & mask;
+        }
+    }
+
+    template<typename... Args>
+    void construct_at(usize idx, Args&&... args) {
+        slot_alloc alloc { m_alloc };
+        try {
+            slot_trait::construct(alloc, m_slots + idx, std::forward<Args>(args)...);
+        } catch (...) {
+            m_ctrl[idx] = deleted_ctrl;
+            throw;
+        }
+        ++m_size;
+    }
+
+    void destroy_at(usize idx) {
+        slot_alloc alloc { m_alloc };
+        slot_trait::destroy(alloc, m_slots + idx);
+    }
+
+    void erase_at(usize idx) {
+        destroy_at(idx);
+        --m_size;
+        // a group that never filled up can't be on another key's probe path
+        Group grp { m_ctrl + idx / group_size * group_size };
+        if (grp.match_empty()) {
+            m_ctrl[idx] = empty_ctrl;
+            ++m_growth_left;
+        } else {
+            m_ctrl[idx] = deleted_ctrl;
+        }
+    }
+
+    void rehash(usize cap) {
+        ctrl_alloc calloc { m_alloc };
+        slot_alloc salloc { m_alloc };
+
+        auto* old_ctrl  = m_ctrl;
+        auto* old_slots = m_slots;
+        auto  old_cap   = m_capacity;
+
+        m_ctrl  = ctrl_trait::allocate(calloc, cap);
+        m_slots = slot_trait::allocate(salloc, cap);
+        std::memset(m_ctrl, empty_ctrl, cap);
+        m_capacity    = cap;
+        m_size        = 0;
+        m_growth_left = max_load(cap);
+
+        for (usize i = 0; i < old_cap; i++) {
+            if (! is_full(old_ctrl[i])) continue;
+            auto& v       = old_slots[i];
+            auto [idx, _] = prepare_insert(v.first);
+            construct_at(idx, std::move(v));
+            slot_trait::destroy(salloc, old_slots + i);
+        }
+        if (old_cap) {
+            ctrl_trait::deallocate(calloc, old_ctrl, old_cap);
+            slot_trait::deallocate(salloc, old_slots, old_cap);
+        }
+    }
+
+    void release() {
+        if (! m_capacity) return;
+        for (usize i = 0; i < m_capacity; i++) {
+            if (is_full(m_ctrl[i])) destroy_at(i);
+        }
+        ctrl_alloc calloc { m_alloc };
+        slot_alloc salloc { m_alloc };
+        ctrl_trait::deallocate(calloc, m_ctrl, m_capacity);
+        slot_trait::deallocate(salloc, m_slots, m_capacity);
+        m_ctrl        = nullptr;
+        m_slots       = nullptr;
+        m_capacity    = 0;
+        m_size        = 0;
+        m_growth_left = 0;
+    }
+
+    Allocator  m_alloc;
+    ctrl_t*    m_ctrl;
+    slot_type* m_slots;
+    usize      m_capacity;
+    usize      m_size;
+    usize      m_growth_left;
+};
+
+#ifdef META_MODEL_STD_HASH_MAP
+template<typename K, typename V, typename Allocator>
+using HashMap = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>,
+                                   rebind_alloc<Allocator, std::pair<const K, V>>>;
+#else
+///
+/// @brief hash map of hashed stores and indexes
+template<typename K, typename V, typename Allocator>
+using HashMap = FlatMap<K, V, std::hash<K>, std::equal_to<K>,
+                        rebind_alloc<Allocator, std::pair<const K, V>>>;
+#endif
+///
+/// @brief hash map that keeps values at the same address until erased
+/// node based, a flat table of pointers to entries was slower on lookup
+template<typename K, typename V, typename Allocator>
+using StableHashMap = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>,
+                                         rebind_alloc<Allocator, std::pair<const K, V>>>;
+
+} // namespace detail
+} // namespace meta_model
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <concepts>
 #include <cstdint>
 #include <cstddef>
+#include <memory>
 #include <utility>
+#include <tuple>
 #include <system_error>
 
 namespace meta_model
@@ -37,6 +40,17 @@ concept special_of = is_specialization_of<T, Primary>::value;
 ///
 /// // storeable:
 /// using store_type = ...;
+/// // optional, memory of an item for ShareStore retention budgets, sizeof(T) if absent
+/// static auto bytes(T) noexcept -> usize;
+///
+/// // optional, unchanged items are not stored again nor notified,
+/// // checked in order: version, equal, operator==
+/// static auto version(T) noexcept -> std::integral auto;
+/// static auto equal(T, T) noexcept -> bool;
+///
+/// // role readable:
+/// // one member pointer or getter per Q_PROPERTY, in declaration order
+/// static constexpr auto roles = std::tuple { &T::a, &T::b };
 /// @endcode
 /// @tparam Item type
 template<typename T>
@@ -44,6 +58,9 @@ struct ItemTrait;
 
 namespace detail
 {
+template<typename Allocator, typename T>
+using rebind_alloc = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+
 template<typename T>
 concept hashable = requires(T k) {
     { std::hash<T> {}(k) } -> std::same_as<usize>;
@@ -66,6 +83,47 @@ concept comparable_item = std::semiregular<ItemTrait<T>> && requires(T t) {
     { ItemTrait<T>::compare_lt(t, t) } -> std::same_as<bool>;
 };
 
+///
+/// @brief Item that defined roles in ItemTrait
+template<typename T>
+concept role_readable_item = requires() {
+    { std::tuple_size<std::remove_cvref_t<decltype(ItemTrait<T>::roles)>>::value };
+};
+
+///
+/// @brief Item that defined bytes in ItemTrait
+template<typename T>
+concept sized_item = requires(T t) {
+    { ItemTrait<T>::bytes(t) } -> std::convertible_to<usize>;
+};
+
+///
+/// @brief Item that defined version in ItemTrait
+template<typename T>
+concept versioned_item = requires(T t) {
+    { ItemTrait<T>::version(t) } -> std::integral;
+};
+
+namespace detail
+{
+///
+/// @brief whether b has the same content as a, false when it can't tell
+template<typename T>
+auto same_item(const T& a, const T& b) -> bool {
+    if constexpr (versioned_item<T>) {
+        return ItemTrait<T>::version(a) == ItemTrait<T>::version(b);
+    } else if constexpr (requires {
+                             { ItemTrait<T>::equal(a, b) } -> std::convertible_to<bool>;
+                         }) {
+        return ItemTrait<T>::equal(a, b);
+    } else if constexpr (std::equality_comparable<T>) {
+        return a == b;
+    } else {
+        return false;
+    }
+}
+} // namespace detail
+
 template<typename T>
     requires std::is_arithmetic_v<T>
 struct ItemTrait<T> {
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <vector>
+
+#include "meta_model/flat_map.hpp"
+#include "meta_model/item_trait.hpp"
+
+namespace meta_model
+{
+namespace detail
+{
+
+///
+/// @brief key to row index, with O(log n) positional insert/erase/move
+/// an implicit treap ordered by row, nodes are found by key through a hash map
+/// and ranked by walking up to the root
+template<typename K, typename Allocator>
+class OrderIndex {
+    struct Node {
+        K           key;
+        Node*       left;
+        Node*       right;
+        Node*       parent;
+        std::size_t size;
+        std::uint32_t prio;
+    };
+
+    template<typename U>
+    using rebind_alloc     = typename std::allocator_traits<Allocator>::template rebind_alloc<U>;
+    using node_allocator   = rebind_alloc<Node>;
+    using node_alloc_trait = std::allocator_traits<node_allocator>;
+    using map_type         = HashMap<K, Node*, Allocator>;
+
+public:
+    OrderIndex(Allocator alloc = Allocator())
+        : m_alloc(alloc), m_map(alloc), m_root(nullptr), m_seed(0x9e3779b9u) {}
+    ~OrderIndex() { clear(); }
+    OrderIndex(const OrderIndex&)            = delete;
+    OrderIndex& operator=(const OrderIndex&) = delete;
+
+    ///
+    /// @brief swap contents in O(1), allocators must compare equal
+    void swap(OrderIndex& o) noexcept {
+        using std::swap;
+        swap(m_map, o.m_map);
+        swap(m_root, o.m_root);
+        swap(m_seed, o.m_seed);
+    }
+
+    auto size() const -> usize { return m_map.size(); }
+    bool contains(param_type<K> key) const { return m_map.contains(key); }
+
+    auto index_of(param_type<K> key) const -> std::optional<usize> {
+        if (auto it = m_map.find(key); it != m_map.end()) {
+            return rank(it->second);
+        }
+        return std::nullopt;
+    }
+
+    ///
+    /// @brief insert keys before pos, keys must not exist
+    template<std::ranges::range U>
+    void insert(usize pos, U&& keys) {
+        Node* sub = build(std::forward<U>(keys));
+        if (! sub) return;
+        auto [l, r] = split(m_root, pos);
+        m_root      = merge(merge(l, sub), r);
+        m_root->parent = nullptr;
+    }
+
+    void erase(usize pos, usize last) {
+        if (pos >= last) return;
+        auto [l, rest] = split(m_root, pos);
+        auto [mid, r]  = split(rest, last - pos);
+        destroy(mid, true);
+        m_root = merge(l, r);
+        if (m_root) m_root->parent = nullptr;
+    }
+
+    ///
+    /// @brief same semantic as QAbstractItemModel::moveRows
+    void move(usize src, usize dst, usize count) {
+        if (count == 0 || src == dst) return;
+        auto [a, rest1] = split(m_root, std::min(src, dst));
+        if (src > dst) {
+            auto [between, rest2] = split(rest1, src - dst);
+            auto [block, c]       = split(rest2, count);
+            m_root                = merge(merge(merge(a, block), between), c);
+        } else {
+            auto [block, rest2] = split(rest1, count);
+            auto [between, c]   = split(rest2, dst - src - count);
+            m_root              = merge(merge(merge(a, between), block), c);
+        }
+        if (m_root) m_root->parent = nullptr;
+    }
+
+    void clear() {
+        destroy(m_root, false);
+        m_root = nullptr;
+        m_map.clear();
+    }
+
+private:
+    static auto size_of(Node* n) -> usize { return n ? n->size : 0; }
+    static void update(Node* n) {
+        n->size = 1 + size_of(n->left) + size_of(n->right);
+        if (n->left) n->left->parent = n;
+        if (n->right) n->right->parent = n;
+    }
+
+    static auto rank(const Node* n) -> usize {
+        usize r = size_of(n->left);
+        for (; n->parent; n = n->parent) {
+            if (n->parent->right == n) r += size_of(n->parent->left) + 1;
+        }
+        return r;
+    }
+
+    // first `count` rows to the left
+    static auto split(Node* n, usize count) -> std::pair<Node*, Node*> {
+        if (! n) return { nullptr, nullptr };
+        n->parent = nullptr;
+        if (size_of(n->left) >= count) {
+            auto [l, r] = split(n->left, count);
+            n->left     = r;
+            update(n);
+            return { l, n };
+        } else {
+            auto [l, r] = split(n->right, count - size_of(n->left) - 1);
+            n->right    = l;
+            update(n);
+            return { n, r };
+        }
+    }
+
+    static auto merge(Node* l, Node* r) -> Node* {
+        if (! l) return r;
+        if (! r) return l;
+        if (l->prio > r->prio) {
+            l->right = merge(l->right, r);
+            update(l);
+            return l;
+        } else {
+            r->left = merge(l, r->left);
+            update(r);
+            return r;
+        }
+    }
+
+    auto next_prio() -> std::uint32_t {
+        // xorshift32
+        m_seed ^= m_seed << 13;
+        m_seed ^= m_seed >> 17;
+        m_seed ^= m_seed << 5;
+        return m_seed;
+    }
+
+    // cartesian tree build in O(n)
+    template<std::ranges::range U>
+    auto build(U&& keys) -> Node* {
+        node_allocator                          alloc { m_alloc };
+        std::vector<Node*, rebind_alloc<Node*>> stack(m_alloc);
+        for (auto&& k : keys) {
+            Node* n = node_alloc_trait::allocate(alloc, 1);
+            node_alloc_trait::construct(
+                alloc, n, Node { k, nullptr, nullptr, nullptr, 1, next_prio() });
+            m_map.insert_or_assign(n->key, n);
+
+            Node* last = nullptr;
+            while (! stack.empty() && stack.back()->prio < n->prio) {
+                last = stack.back();
+                update(last);
+                stack.pop_back();
+            }
+            n->left = last;
+            if (! stack.empty()) stack.back()->right = n;
+            stack.push_back(n);
+        }
+        for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
+            update(*it);
+        }
+        if (stack.empty()) return nullptr;
+        stack.front()->parent = nullptr;
+        return stack.front();
+    }
+
+    void destroy(Node* n, bool unmap) {
+        if (! n) return;
+        destroy(n->left, unmap);
+        destroy(n->right, unmap);
+        if (unmap) m_map.erase(n->key);
+        node_allocator alloc { m_alloc };
+        node_alloc_trait::destroy(alloc, n);
+        node_alloc_trait::deallocate(alloc, n, 1);
+    }
+
+    Allocator     m_alloc;
+    map_type      m_map;
+    Node*         m_root;
+    std::uint32_t m_seed;
+};
+
+} // namespace detail
+} // namespace meta_model
@@ -0,0 +1,417 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <QtCore/QFuture>
+#include <QtCore/QObject>
+#include <QtCore/QPromise>
+#include <QtCore/QThreadPool>
+
+#include "meta_model/qmeta_list_model.hpp"
+
+namespace meta_model
+{
+
+///
+/// @brief rows [offset, offset + items.size()) of a paged source
+template<typename T>
+struct Page {
+    std::vector<T> items;
+    bool           has_more { false };
+};
+
+///
+/// @brief async source of pages for a PageLoader
+template<typename T>
+class PageProvider {
+public:
+    virtual ~PageProvider() = default;
+
+    ///
+    /// @brief fetch up to count rows starting at offset
+    /// the future may resolve on any thread, decode the page there so the
+    /// model thread only appends; a canceled or failed future drops the page
+    /// rows missing from a short page are requested again, an empty page with
+    /// has_more counts as failed
+    virtual auto fetch(qint64 offset, qint32 count) -> QFuture<Page<T>> = 0;
+};
+
+///
+/// @brief provider over local rows, built on a worker thread after latency
+/// stands in for a slow backend, e.g. to try scrolling against it
+/// row is called from worker threads
+template<typename T>
+class LocalPageProvider : public PageProvider<T> {
+public:
+    using row_fn = std::function<T(qint64)>;
+
+    LocalPageProvider(qint64 total, row_fn row,
+                      std::chrono::milliseconds latency = std::chrono::milliseconds { 0 })
+        : m_total(total), m_row(std::move(row)), m_latency(latency), m_fetches(0) {}
+    ~LocalPageProvider() { m_pool.waitForDone(); }
+
+    auto fetch(qint64 offset, qint32 count) -> QFuture<Page<T>> override {
+        m_fetches.fetch_add(1, std::memory_order_relaxed);
+        auto promise = std::make_shared<QPromise<Page<T>>>();
+        auto future  = promise->future();
+        promise->start();
+        m_pool.start([this, promise, offset, count] {
+            std::this_thread::sleep_for(m_latency.load(std::memory_order_relaxed));
+            if (! promise->isCanceled()) {
+                Page<T> page;
+                auto    end = std::clamp<qint64>(offset + count, offset, m_total);
+                page.items.reserve(std::max<qint64>(end - offset, 0));
+                for (auto i = offset; i < end; i++) {
+                    page.items.push_back(m_row(i));
+                }
+                page.has_more = end < m_total;
+                promise->addResult(std::move(page));
+            }
+            promise->finish();
+        });
+        return future;
+    }
+
+    void set_latency(std::chrono::milliseconds latency) { m_latency = latency; }
+    auto fetches() const -> usize { return m_fetches.load(std::memory_order_relaxed); }
+
+private:
+    qint64                                 m_total;
+    row_fn                                 m_row;
+    std::atomic<std::chrono::milliseconds> m_latency;
+    std::atomic<usize>                     m_fetches;
+    QThreadPool                            m_pool;
+};
+
+struct PageOptions {
+    // rows per request
+    qint32 page_size { 50 };
+    // rows kept loaded past the visible rows
+    qint32 prefetch { 100 };
+    // pages requested at the same time, per direction
+    qint32 max_in_flight { 2 };
+    // rows kept in the model, 0 to keep all
+    // rows far from the visible ones, as told by setVisibleRows, are dropped and
+    // fetched again when scrolled back to; prefetch rows on each side are never
+    // dropped, so a window below visible rows + 2 * prefetch can be exceeded
+    qint32 window { 0 };
+};
+
+namespace detail
+{
+class PageLoaderBase : public QObject {
+    Q_OBJECT
+
+    Q_PROPERTY(bool loading READ loading NOTIFY loadingChanged FINAL)
+    Q_PROPERTY(bool hasPrevious READ hasPrevious NOTIFY windowChanged FINAL)
+    Q_PROPERTY(qint64 firstOffset READ firstOffset NOTIFY windowChanged FINAL)
+public:
+    PageLoaderBase(QObject* parent = nullptr);
+    virtual ~PageLoaderBase();
+
+    auto          loading() const -> bool;
+    Q_SIGNAL void loadingChanged(bool);
+
+    ///
+    /// @brief offset of row 0, rows before it were dropped from the window
+    auto          firstOffset() const -> qint64;
+    auto          hasPrevious() const -> bool;
+    Q_SIGNAL void windowChanged();
+
+    ///
+    /// @brief the view shows rows up to row, load ahead of it
+    /// with a window, rows far before it are dropped as by setVisibleRows(row, row)
+    Q_INVOKABLE void setVisibleRow(qint32 row);
+    ///
+    /// @brief the view shows rows [first, last], load around them
+    Q_INVOKABLE void setVisibleRows(qint32 first, qint32 last);
+    ///
+    /// @brief fetch the page before row 0, the backward fetchMore
+    Q_INVOKABLE void fetchPrevious();
+
+protected:
+    virtual void fill()           = 0;
+    virtual void fill_previous()  = 0;
+    void         setLoading(bool);
+    void         setFirstOffset(qint64);
+
+    qint32 m_visible_first;
+    qint32 m_visible_last;
+
+private:
+    bool   m_loading;
+    qint64 m_first;
+};
+} // namespace detail
+
+///
+/// @brief pages rows of a list model in from a PageProvider
+/// keeps prefetch rows loaded around the visible rows, with up to max_in_flight
+/// pages requested at once and each offset requested once; pages that arrive
+/// in order are added with one insert, or extend for keyed items
+/// with a window, rows past it on the far side of the visible rows are removed
+/// and the rows of the model map to offsets [firstOffset, firstOffset + rowCount)
+/// fetchMore of the model lands here; reset the model through reload
+template<typename Model>
+class PageLoader : public detail::PageLoaderBase {
+public:
+    using item_type     = typename Model::value_type;
+    using page_type     = Page<item_type>;
+    using provider_type = PageProvider<item_type>;
+
+    PageLoader(Model* model, std::shared_ptr<provider_type> provider, PageOptions options = {})
+        : detail::PageLoaderBase(model),
+          m_model(model),
+          m_provider(std::move(provider)),
+          m_options(options),
+          m_next(0),
+          m_prev(0),
+          m_serial(0),
+          m_exhausted(false) {
+        connect(model, &detail::QMetaListModelBase::reqFetchMore, this, [this](qint32 row) {
+            setVisibleRow(row);
+        });
+        m_model->setHasMore(true);
+        fill();
+    }
+    ~PageLoader() {
+        cancel(m_pages, m_pages.begin(), m_pages.end());
+        cancel(m_prev_pages, m_prev_pages.begin(), m_prev_pages.end());
+    }
+
+    ///
+    /// @brief drop all rows and pages in flight, load again from offset 0
+    void reload() {
+        cancel(m_pages, m_pages.begin(), m_pages.end());
+        cancel(m_prev_pages, m_prev_pages.begin(), m_prev_pages.end());
+        m_next          = 0;
+        m_prev          = 0;
+        m_exhausted     = false;
+        m_visible_first = -1;
+        m_visible_last  = -1;
+        setFirstOffset(0);
+        m_model->resetModel();
+        m_model->setHasMore(true);
+        fill();
+    }
+
+    auto options() const -> const PageOptions& { return m_options; }
+    void set_options(const PageOptions& options) {
+        m_options = options;
+        fill();
+    }
+
+    ///
+    /// @brief pages requested and not added yet
+    auto in_flight() const -> usize { return m_pages.size() + m_prev_pages.size(); }
+    auto exhausted() const -> bool { return m_exhausted; }
+
+protected:
+    void fill() override {
+        auto size  = std::max(m_options.page_size, 1);
+        auto ahead = std::max(m_options.prefetch, 0);
+        auto limit = std::max(m_options.max_in_flight, 1);
+
+        auto want_end = firstOffset() + std::max(m_visible_last, 0) + 1 + ahead;
+        while (! m_exhausted && m_next < want_end && (qint64)m_pages.size() < limit) {
+            request(false, m_next, size);
+            m_next += size;
+        }
+        // only a window drops rows before the visible ones
+        auto want_begin = firstOffset() + std::max(m_visible_first, 0) - ahead;
+        while (m_prev > 0 && m_prev > want_begin && (qint64)m_prev_pages.size() < limit) {
+            fill_previous();
+        }
+        setLoading(in_flight() > 0);
+    }
+
+    void fill_previous() override {
+        if (m_prev <= 0) return;
+        auto offset = std::max<qint64>(m_prev - std::max(m_options.page_size, 1), 0);
+        request(true, offset, m_prev - offset);
+        m_prev = offset;
+        setLoading(true);
+    }
+
+private:
+    struct Pending {
+        QFuture<page_type>       future;
+        std::optional<page_type> page;
+        qint32                   count;
+        std::uint64_t            serial;
+    };
+    using pages_type = std::map<qint64, Pending>;
+
+    void request(bool back, qint64 offset, qint32 count) {
+        auto serial = ++m_serial;
+        auto future = m_provider->fetch(offset, count);
+        (back ? m_prev_pages : m_pages)
+            .insert_or_assign(offset, Pending { future, std::nullopt, count, serial });
+        future
+            .then(this,
+                  [this, back, offset, serial](QFuture<page_type> f) {
+                      if (f.resultCount() > 0) {
+                          arrive(back, offset, serial, f.takeResult());
+                      } else {
+                          fail(back, offset, serial);
+                      }
+                  })
+            .onCanceled(this, [this, back, offset, serial] {
+                fail(back, offset, serial);
+            });
+    }
+
+    auto find(pages_type& pages, qint64 offset, std::uint64_t serial) {
+        auto it = pages.find(offset);
+        return it != pages.end() && it->second.serial == serial ? it : pages.end();
+    }
+
+    void arrive(bool back, qint64 offset, std::uint64_t serial, page_type page) {
+        auto& pages = back ? m_prev_pages : m_pages;
+        auto  it    = find(pages, offset, serial);
+        if (it == pages.end()) return;
+
+        // a short page leaves rows [offset + n, offset + count) to fetch
+        auto n = (qint32)page.items.size();
+        if (n < it->second.count && (back || page.has_more)) {
+            if (n == 0) {
+                fail(back, offset, serial);
+                return;
+            }
+            request(back, offset + n, it->second.count - n);
+            it->second.count = n;
+        }
+        it->second.future = {};
+        it->second.page   = std::move(page);
+
+        if (back) {
+            prepend_ready();
+        } else {
+            append_ready();
+        }
+        setLoading(in_flight() > 0);
+        fill();
+    }
+
+    // pages ready in order after the last row, as one batch
+    void append_ready() {
+        std::vector<item_type> batch;
+        while (! m_pages.empty() && m_pages.begin()->second.page) {
+            auto& page = *m_pages.begin()->second.page;
+            if (batch.empty()) {
+                batch = std::move(page.items);
+            } else {
+                batch.insert(batch.end(),
+                             std::make_move_iterator(page.items.begin()),
+                             std::make_move_iterator(page.items.end()));
+            }
+            if (! page.has_more) {
+                m_exhausted = true;
+                cancel(m_pages, m_pages.begin(), m_pages.end());
+                break;
+            }
+            m_pages.erase(m_pages.begin());
+        }
+        if (! batch.empty()) {
+            if constexpr (hashable_item<item_type>) {
+                m_model->extend(std::move(batch));
+            } else {
+                m_model->insert(m_model->rowCount(), std::move(batch));
+            }
+            // drop rows before the visible ones, past prefetch so fill doesn't want them back
+            auto ahead = std::max(m_options.prefetch, 0);
+            auto over  = m_model->rowCount() - m_options.window;
+            auto n     = std::min(over, std::max(m_visible_first, 0) - ahead);
+            if (m_options.window > 0 && n > 0) {
+                cancel(m_prev_pages, m_prev_pages.begin(), m_prev_pages.end());
+                m_model->remove(0, n);
+                m_visible_first -= n;
+                m_visible_last -= n;
+                m_prev = firstOffset() + n;
+                setFirstOffset(m_prev);
+            }
+        }
+        m_model->setHasMore(! m_exhausted);
+    }
+
+    // pages ready in order before row 0, as one batch
+    void prepend_ready() {
+        std::vector<item_type> batch;
+        auto                   first = firstOffset();
+        while (! m_prev_pages.empty() && std::prev(m_prev_pages.end())->second.page) {
+            auto  last  = std::prev(m_prev_pages.end());
+            auto& items = last->second.page->items;
+            items.insert(items.end(),
+                         std::make_move_iterator(batch.begin()),
+                         std::make_move_iterator(batch.end()));
+            batch = std::move(items);
+            first = last->first;
+            m_prev_pages.erase(last);
+        }
+        if (batch.empty()) {
+            if (first != firstOffset()) setFirstOffset(first);
+            return;
+        }
+        auto n = (qint32)batch.size();
+        m_model->insert(0, std::move(batch));
+        m_visible_first += n;
+        m_visible_last += n;
+        setFirstOffset(first);
+
+        // drop rows after the visible ones, past prefetch
+        auto ahead = std::max(m_options.prefetch, 0);
+        auto over  = m_model->rowCount() - m_options.window;
+        auto drop  = std::min(over, m_model->rowCount() - 1 - std::max(m_visible_last, 0) - ahead);
+        if (m_options.window > 0 && drop > 0) {
+            cancel(m_pages, m_pages.begin(), m_pages.end());
+            m_model->remove(m_model->rowCount() - drop, drop);
+            m_next      = firstOffset() + m_model->rowCount();
+            m_exhausted = false;
+            m_model->setHasMore(true);
+        }
+    }
+
+    void fail(bool back, qint64 offset, std::uint64_t serial) {
+        auto& pages = back ? m_prev_pages : m_pages;
+        auto  it    = find(pages, offset, serial);
+        if (it == pages.end()) return;
+        // pages beyond it can't be added, request them again on the next fetch
+        if (back) {
+            m_prev = offset + it->second.count;
+            cancel(pages, pages.begin(), std::next(it));
+        } else {
+            m_next = offset;
+            cancel(pages, it, pages.end());
+            m_model->setHasMore(true);
+        }
+        setLoading(in_flight() > 0);
+    }
+
+    void cancel(pages_type& pages, pages_type::iterator first, pages_type::iterator last) {
+        for (auto it = first; it != last; ++it) {
+            it->second.future.cancel();
+        }
+        pages.erase(first, last);
+    }
+
+    Model*                         m_model;
+    std::shared_ptr<provider_type> m_provider;
+    PageOptions                    m_options;
+    // forward, offsets from the last row
+    pages_type m_pages;
+    qint64     m_next;
+    // backward, offsets before row 0
+    pages_type    m_prev_pages;
+    qint64        m_prev;
+    std::uint64_t m_serial;
+    bool          m_exhausted;
+};
+
+} // namespace meta_model
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory_resource>
 #include <type_traits>
 
 #include "meta_model/qgadget_helper.hpp"
@@ -23,11 +24,20 @@ public:
 
     // override
     virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override {
-        if (auto prop = this->propertyOfRole(role); prop) {
+        if constexpr (role_readable_item<TGadget>) {
+            return detail::read_role(this->at(index.row()), role);
+        } else if (auto prop = this->propertyOfRole(role); prop) {
             return prop.value().readOnGadget(&this->at(index.row()));
         }
         return {};
     };
 };
 
+namespace pmr
+{
+template<typename TGadget, QMetaListStore Store = QMetaListStore::Vector>
+using QGadgetListModel = meta_model::QGadgetListModel<
+    TGadget, Store, std::pmr::polymorphic_allocator<detail::allocator_value_type<TGadget, Store>>>;
+} // namespace pmr
+
 } // namespace meta_model
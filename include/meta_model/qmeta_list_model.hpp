@@ -5,16 +5,25 @@
 #    define __cplusplus 202002
 #endif
 
+#include <bit>
+#include <limits>
+#include <numeric>
 #include <ranges>
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
 #include <set>
+#include <list>
+#include <stdexcept>
+#include <functional>
 
 #include <QtCore/QAbstractItemModel>
 #include "meta_model/qmeta_model_base.hpp"
 #include "meta_model/item_trait.hpp"
 #include "meta_model/share_store.hpp"
+#include "meta_model/order_index.hpp"
+#include "meta_model/chunked_list.hpp"
+#include "meta_model/sync_plan.hpp"
 
 namespace meta_model
 {
@@ -24,7 +33,9 @@ enum class QMetaListStore
     Vector = 0,
     VectorWithMap,
     Map,
-    Share
+    Share,
+    Chunked,
+    Lazy
 };
 
 namespace detail
@@ -42,19 +53,85 @@ struct allocator_helper<T, QMetaListStore::Map> {
 template<typename T, QMetaListStore S>
 using allocator_value_type = allocator_helper<T, S>::value_type;
 
-template<typename Allocator, typename T>
-using rebind_alloc = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
-
 template<typename T, typename Allocator>
 using Set = std::set<T, std::less<>, rebind_alloc<Allocator, T>>;
 
-template<typename K, typename V, typename Allocator>
-using HashMap = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>,
-                                   rebind_alloc<Allocator, std::pair<const K, V>>>;
-
 template<typename T, typename Allocator, QMetaListStore Store>
 class ListImpl;
 
+///
+/// @brief U&& owns its elements and expires, so they can be moved out
+/// views and borrowed ranges refer to elements owned elsewhere
+template<typename U>
+concept movable_range = ! std::is_lvalue_reference_v<U> &&
+                        ! std::ranges::view<std::remove_cvref_t<U>> &&
+                        ! std::ranges::borrowed_range<U>;
+
+///
+/// @brief an element of range U, as rvalue if the range is movable_range
+template<typename U, typename E>
+decltype(auto) forward_element(E& el) {
+    if constexpr (movable_range<U>) {
+        return std::move(el);
+    } else {
+        return static_cast<E&>(el);
+    }
+}
+
+///
+/// @brief elements [first, last) of range U, as rvalues if the range is movable_range
+template<typename U>
+auto forward_range(std::remove_reference_t<U>& range, usize first, usize last) {
+    auto begin = std::ranges::next(std::ranges::begin(range), first);
+    auto end   = std::ranges::next(begin, last - first);
+    if constexpr (movable_range<U>) {
+        return std::ranges::subrange(std::make_move_iterator(begin), std::make_move_iterator(end));
+    } else {
+        return std::ranges::subrange(begin, end);
+    }
+}
+template<typename U>
+auto forward_range(std::remove_reference_t<U>& range) {
+    if constexpr (movable_range<U>) {
+        return std::ranges::subrange(std::make_move_iterator(std::ranges::begin(range)),
+                                     std::move_sentinel(std::ranges::end(range)));
+    } else {
+        return std::ranges::subrange(std::ranges::begin(range), std::ranges::end(range));
+    }
+}
+
+///
+/// @brief roles of fields, empty for all
+inline auto field_roles(FieldMask fields) -> QList<int> {
+    QList<int> roles;
+    if (fields == all_fields) return roles;
+    for (; fields; fields &= fields - 1) {
+        roles.push_back(RoleTable::first_role + std::countr_zero(fields));
+    }
+    return roles;
+}
+
+template<typename T, std::size_t... I>
+auto read_role_impl(const T& item, int idx, std::index_sequence<I...>) -> QVariant {
+    QVariant out;
+    (void)((idx == (int)I
+                ? (out = QVariant::fromValue(std::invoke(std::get<I>(ItemTrait<T>::roles), item)),
+                   true)
+                : false) ||
+           ...);
+    return out;
+}
+
+///
+/// @brief read role from item with ItemTrait::roles, without QMetaProperty
+template<role_readable_item T>
+auto read_role(const T& item, int role) -> QVariant {
+    using roles_type = std::remove_cvref_t<decltype(ItemTrait<T>::roles)>;
+    return read_role_impl(item,
+                          role - RoleTable::first_role,
+                          std::make_index_sequence<std::tuple_size_v<roles_type>> {});
+}
+
 class QMetaListModelBase : public QMetaModelBase<QAbstractListModel> {
     Q_OBJECT
 
@@ -76,8 +153,51 @@ public:
     Q_SIGNAL void hasMoreChanged(bool);
     Q_SIGNAL void reqFetchMore(qint32);
 
+    ///
+    /// @brief defer dataChanged until the outermost endUpdate
+    /// deferred rows are merged into ranges, and follow rows inserted, removed
+    /// or moved meanwhile
+    void beginUpdate();
+    void endUpdate();
+    auto inUpdate() const -> bool;
+
+    ///
+    /// @brief bumped when rows are inserted, removed, moved or reset
+    auto rowsVersion() const -> std::uint64_t;
+
+    ///
+    /// @brief emit dataChanged of rows [first, last], deferred inside an update
+    /// empty roles means all roles
+    void notifyDataChanged(int first, int last, const QList<int>& roles = {});
+
+    class UpdateGuard {
+    public:
+        UpdateGuard(QMetaListModelBase& model): m_model(model) { m_model.beginUpdate(); }
+        ~UpdateGuard() { m_model.endUpdate(); }
+        UpdateGuard(const UpdateGuard&)            = delete;
+        UpdateGuard& operator=(const UpdateGuard&) = delete;
+
+    private:
+        QMetaListModelBase& m_model;
+    };
+
 private:
-    bool m_has_more;
+    struct PendingChange {
+        int        first;
+        int        last;
+        QList<int> roles;
+    };
+    template<typename F>
+    void remapPending(std::initializer_list<int> cuts, F&& map);
+
+    bool                       m_has_more;
+    int                        m_update_depth;
+    std::vector<PendingChange> m_pending;
+    std::uint64_t              m_rows_version;
+
+protected:
+    // by each change of rows, not from their signals, which may be blocked
+    void bumpRowsVersion() { ++m_rows_version; }
 };
 
 template<typename TItem, QMetaListStore Store, typename Allocator, typename IMPL>
@@ -104,6 +224,7 @@ public:
         size = crtp_impl()._insert_len(range);
         beginInsertRows({}, index, index + size - 1);
         crtp_impl()._insert_impl(index, std::forward<T>(range));
+        bumpRowsVersion();
         endInsertRows();
         return size;
     }
@@ -112,35 +233,56 @@ public:
         removeRows(index, size);
     }
     auto removeRows(int row, int count, const QModelIndex& parent = {}) -> bool override {
-        if (count < 1) return false;
-        beginRemoveRows(parent, row, row + count - 1);
-        crtp_impl()._erase_impl(row, row + count);
-        endRemoveRows();
-        return true;
+        if constexpr (Store == QMetaListStore::Lazy) {
+            return false;
+        } else {
+            if (count < 1) return false;
+            beginRemoveRows(parent, row, row + count - 1);
+            crtp_impl()._erase_impl(row, row + count);
+            bumpRowsVersion();
+            endRemoveRows();
+            return true;
+        }
     }
     template<typename Func>
     void remove_if(Func&& func) {
-        std::set<int, std::greater<>> indexes;
+        // contiguous runs of [begin, end)
+        std::vector<std::pair<int, int>, rebind_alloc<std::pair<int, int>>> runs(
+            crtp_impl().get_allocator());
         for (int i = 0; i < rowCount(); i++) {
             auto& el = crtp_impl().at(i);
             if (func(el)) {
-                indexes.insert(i);
+                if (! runs.empty() && runs.back().second == i) {
+                    runs.back().second = i + 1;
+                } else {
+                    runs.emplace_back(i, i + 1);
+                }
             }
         }
-        for (auto& i : indexes) {
-            removeRow(i);
+        // from back, rows of front runs stay valid
+        for (auto it = runs.rbegin(); it != runs.rend(); ++it) {
+            removeRows(it->first, it->second - it->first);
         }
     }
-    void replace(int row, param_type<TItem> val) {
-        auto& item = crtp_impl().at(row);
-        item       = val;
-        auto idx   = index(row);
-        dataChanged(idx, idx);
-    }
+    void replace(int row, param_type<TItem> val) { assignRow(row, val); }
 
     void resetModel() {
         beginResetModel();
         crtp_impl()._reset_impl();
+        bumpRowsVersion();
+        endResetModel();
+    }
+
+    ///
+    /// @brief reset a Lazy model to size rows, read from its provider on access
+    void resetModel(usize size)
+        requires(Store == QMetaListStore::Lazy)
+    {
+        // rowCount is an int
+        Q_ASSERT(size <= (usize)std::numeric_limits<int>::max());
+        beginResetModel();
+        crtp_impl()._reset_impl(size);
+        bumpRowsVersion();
         endResetModel();
     }
 
@@ -153,15 +295,17 @@ public:
         } else {
             crtp_impl()._reset_impl();
         }
+        bumpRowsVersion();
         endResetModel();
     }
 
     template<typename T>
         requires std::ranges::sized_range<T>
     // std::same_as<std::decay_t<typename T::value_type>, TItem>
-    void resetModel(const T& items) {
+    void resetModel(T&& items) {
         beginResetModel();
-        crtp_impl()._reset_impl(items);
+        crtp_impl()._reset_impl(std::forward<T>(items));
+        bumpRowsVersion();
         endResetModel();
     }
     template<typename T>
@@ -170,10 +314,18 @@ public:
         auto  size = items.size();
         usize old  = std::max(rowCount(), 0);
         auto  num  = std::min<int>(old, size);
-        for (auto i = 0; i < num; i++) {
-            crtp_impl().at(i) = items[i];
+        bool  moved { false };
+        {
+            UpdateGuard guard { *this };
+            for (auto i = 0; i < num && ! moved; i++) {
+                moved = ! tryAssignRow(i, items[i]);
+            }
+        }
+        // a key moved to another row, rows can't be assigned in place
+        if (moved) {
+            resetModel(items);
+            return;
         }
-        if (num > 0) dataChanged(index(0), index(num));
         if (size > old) {
             insert(num, std::ranges::subrange(items.begin() + num, items.end(), size - num));
         } else if (size < old) {
@@ -183,19 +335,27 @@ public:
 
     bool moveRows(const QModelIndex& sourceParent, int sourceRow, int count,
                   const QModelIndex& destinationParent, int destinationChild) override {
-        if (sourceRow < 0 || sourceRow + count - 1 >= rowCount(sourceParent) ||
-            destinationChild < 0 || destinationChild > rowCount(destinationParent) ||
-            sourceRow == destinationChild - 1 || count <= 0 || sourceParent.isValid() ||
-            destinationParent.isValid()) {
+        if constexpr (Store == QMetaListStore::Lazy) {
             return false;
+        } else {
+            if (sourceRow < 0 || sourceRow + count - 1 >= rowCount(sourceParent) ||
+                destinationChild < 0 || destinationChild > rowCount(destinationParent) ||
+                sourceRow == destinationChild - 1 || count <= 0 || sourceParent.isValid() ||
+                destinationParent.isValid()) {
+                return false;
+            }
+            if (! beginMoveRows(QModelIndex(),
+                                sourceRow,
+                                sourceRow + count - 1,
+                                QModelIndex(),
+                                destinationChild))
+                return false;
+
+            crtp_impl()._move_impl(sourceRow, destinationChild, count);
+            bumpRowsVersion();
+            endMoveRows();
+            return true;
         }
-        if (! beginMoveRows(
-                QModelIndex(), sourceRow, sourceRow + count - 1, QModelIndex(), destinationChild))
-            return false;
-
-        crtp_impl()._move_impl(sourceRow, destinationChild, count);
-        endMoveRows();
-        return true;
     }
 
     bool move(int sourceRow, int destinationRow, int count) override {
@@ -216,6 +376,9 @@ public:
         }
     }
 
+    ///
+    /// @brief rows as QVariant, all rows for n = -1
+    /// on Lazy all rows load every block through the cache, ask for a range instead
     auto items(qint32 offset = 0, qint32 n = -1) const -> QVariantList override {
         if (n == -1) n = rowCount();
         auto view = std::views::transform(std::views::iota(offset, n), [this](qint32 idx) {
@@ -228,7 +391,97 @@ public:
         return crtp_impl().size();
     }
 
+protected:
+    // rows indexed by a unique key
+    static constexpr bool keyed_store = Store == QMetaListStore::VectorWithMap ||
+                                        Store == QMetaListStore::Map ||
+                                        Store == QMetaListStore::Share;
+
+    ///
+    /// @brief roles that differ between a and b
+    /// empty if nothing changed, nullopt if unknown
+    auto diffRoles(const TItem& a, const TItem& b) const -> std::optional<QList<int>> {
+        if constexpr (role_readable_item<TItem>) {
+            QList<int> roles;
+            using roles_type = std::remove_cvref_t<decltype(ItemTrait<TItem>::roles)>;
+            diff_roles(a, b, roles, std::make_index_sequence<std::tuple_size_v<roles_type>> {});
+            return roles;
+        } else if constexpr (requires { typename TItem::QtGadgetHelper; }) {
+            QList<int> roles;
+            auto&      props = this->m_role_table->props;
+            for (usize i = 0; i < props.size(); i++) {
+                if (props[i].readOnGadget(&a) != props[i].readOnGadget(&b)) {
+                    roles.push_back(RoleTable::first_role + (int)i);
+                }
+            }
+            return roles;
+        } else if constexpr (std::equality_comparable<TItem>) {
+            if (a == b) return QList<int> {};
+            return std::nullopt;
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    ///
+    /// @brief assign val to row, dataChanged with changed roles only
+    /// a key held by another row updates that row and removes this one, as insert does
+    template<typename V>
+    void assignRow(int row, V&& val) {
+        if (tryAssignRow(row, val)) return;
+        if constexpr (keyed_store) {
+            auto other = *crtp_impl().query_idx(ItemTrait<TItem>::key(val));
+            assignRow(other, std::forward<V>(val));
+            removeRows(row, 1);
+        }
+    }
+
+    ///
+    /// @brief assignRow, false without change if the key of val is held by another row
+    template<typename V>
+    bool tryAssignRow(int row, V&& val) {
+        auto& item  = crtp_impl().at(row);
+        bool  rekey = false;
+        if constexpr (hashable_item<TItem>) {
+            rekey = ItemTrait<TItem>::key(item) != ItemTrait<TItem>::key(val);
+            if (rekey) {
+                if constexpr (keyed_store) {
+                    // keys of rows are unique
+                    if (crtp_impl().query_idx(ItemTrait<TItem>::key(val))) return false;
+                }
+                // another key in the row, planned syncs are stale
+                bumpRowsVersion();
+            }
+        }
+        auto roles = diffRoles(item, val);
+        // roles may miss the key
+        if (roles && roles->empty() && ! rekey) return true;
+        if constexpr (keyed_store) {
+            // moves the key of the row, Share goes through the store so other lists see it
+            crtp_impl()._assign_impl(row, std::forward<V>(val));
+        } else {
+            item = std::forward<V>(val);
+        }
+        notifyDataChanged(row, row, roles.value_or(QList<int> {}));
+        return true;
+    }
+
 private:
+    template<std::size_t... I>
+    static void diff_roles(const TItem& a, const TItem& b, QList<int>& out,
+                           std::index_sequence<I...>) {
+        (
+            [&] {
+                const auto& get = std::get<I>(ItemTrait<TItem>::roles);
+                using V         = std::remove_cvref_t<decltype(std::invoke(get, a))>;
+                if constexpr (std::equality_comparable<V>) {
+                    if (std::invoke(get, a) == std::invoke(get, b)) return;
+                }
+                out.push_back(RoleTable::first_role + (int)I);
+            }(),
+            ...);
+    }
+
     auto&       crtp_impl() { return *static_cast<IMPL*>(this); }
     const auto& crtp_impl() const { return *static_cast<const IMPL*>(this); }
 };
@@ -268,7 +521,17 @@ protected:
 
     template<std::ranges::range U>
     void _insert_impl(usize idx, U&& range) {
-        std::ranges::copy(std::forward<U>(range), std::insert_iterator(m_items, begin() + idx));
+        if constexpr (std::ranges::sized_range<U>) {
+            // grow geometrically, an exact reserve would copy on every append
+            auto n = m_items.size() + std::ranges::size(range);
+            if (n > m_items.capacity()) m_items.reserve(std::max(n, 2 * m_items.capacity()));
+        }
+        // append and rotate into place, one shift for the whole range
+        auto old = m_items.size();
+        for (auto&& el : forward_range<U>(range)) {
+            m_items.emplace_back(std::forward<decltype(el)>(el));
+        }
+        std::rotate(m_items.begin() + idx, m_items.begin() + old, m_items.end());
     }
 
     void _erase_impl(usize index, usize last) {
@@ -279,9 +542,9 @@ protected:
     void _reset_impl() { m_items.clear(); }
 
     template<std::ranges::range U>
-    void _reset_impl(const U& items) {
+    void _reset_impl(U&& items) {
         m_items.clear();
-        _insert_impl(0, items);
+        _insert_impl(0, std::forward<U>(items));
     }
 
     void _move_impl(usize sourceRow, usize destinationRow, usize count) {
@@ -295,6 +558,58 @@ protected:
         }
     }
 
+    void _swap_impl(ListImpl& o) noexcept { m_items.swap(o.m_items); }
+
+private:
+    container_type m_items;
+};
+
+template<typename T, typename Allocator>
+class ListImpl<T, Allocator, QMetaListStore::Chunked> {
+public:
+    using allocator_type = Allocator;
+    using container_type = ChunkedList<T, Allocator>;
+    using iterator       = container_type::iterator;
+
+    ListImpl(Allocator allc = Allocator()): m_items(allc) {}
+    auto        begin() const { return std::begin(m_items); }
+    auto        end() const { return std::end(m_items); }
+    auto        begin() { return std::begin(m_items); }
+    auto        end() { return std::end(m_items); }
+    auto        size() const { return std::size(m_items); }
+    const auto& at(usize idx) const { return m_items.at(idx); }
+    auto&       at(usize idx) { return m_items.at(idx); }
+    auto        find(param_type<T> t) const { return std::find(begin(), end(), t); }
+    auto        find(param_type<T> t) { return std::find(begin(), end(), t); }
+    auto        get_allocator() const { return m_items.get_allocator(); }
+
+protected:
+    template<std::ranges::sized_range U>
+    auto _insert_len(U&& range) {
+        return range.size();
+    }
+
+    template<std::ranges::range U>
+    void _insert_impl(usize idx, U&& range) {
+        m_items.insert(idx, forward_range<U>(range));
+    }
+
+    void _erase_impl(usize index, usize last) { m_items.erase(index, last); }
+
+    void _reset_impl() { m_items.clear(); }
+
+    template<std::ranges::range U>
+    void _reset_impl(U&& items) {
+        m_items.clear();
+        _insert_impl(0, std::forward<U>(items));
+    }
+
+    void _move_impl(usize sourceRow, usize destinationRow, usize count) {
+        m_items.move(sourceRow, destinationRow, count);
+    }
+
+    void _swap_impl(ListImpl& o) noexcept { m_items.swap(o.m_items); }
+
 private:
     container_type m_items;
 };
@@ -307,7 +622,7 @@ public:
     using key_type       = ItemTrait<T>::key_type;
     using iterator       = container_type::iterator;
 
-    ListImpl(Allocator allc = Allocator()): m_map(allc), m_items(allc) {}
+    ListImpl(Allocator allc = Allocator()): m_index(allc), m_items(allc) {}
 
     auto        begin() const { return std::begin(m_items); }
     auto        end() const { return std::end(m_items); }
@@ -321,59 +636,77 @@ public:
     auto        get_allocator() const { return m_items.get_allocator(); }
 
     // hash
-    auto contains(param_type<T> t) const { return m_map.contains(ItemTrait<T>::key(t)); }
+    auto contains(param_type<T> t) const { return m_index.contains(ItemTrait<T>::key(t)); }
     auto key_at(usize idx) const { return ItemTrait<T>::key(m_items.at(idx)); }
     auto query_idx(param_type<key_type> key) const -> std::optional<usize> {
-        if (auto it = m_map.find(key); it != m_map.end()) {
-            return it->second;
-        }
-        return std::nullopt;
+        return m_index.index_of(key);
     };
     T* query(param_type<key_type> key) {
         auto idx = this->query_idx(key);
-        if (idx) return this->at(*idx);
+        if (idx) return std::addressof(this->at(*idx));
         return nullptr;
     }
     T const* query(param_type<key_type> key) const {
         auto idx = this->query_idx(key);
-        if (idx) return this->at(*idx);
+        if (idx) return std::addressof(this->at(*idx));
         return nullptr;
     }
 
 protected:
     template<std::ranges::sized_range U>
     auto _insert_len(U&& range) {
-        auto view = std::views::transform(range, [this](auto& el) -> usize {
-            return m_map.contains(ItemTrait<T>::key(el)) ? 0 : 1;
+        auto view = std::views::transform(range, [this](const auto& el) -> usize {
+            return m_index.contains(ItemTrait<T>::key(el)) ? 0 : 1;
         });
         return std::accumulate(view.begin(), view.end(), 0);
     }
 
     template<std::ranges::range U>
     void _insert_impl(usize idx, U&& range) {
-        std::ranges::copy(std::forward<U>(range), std::insert_iterator(m_items, begin() + idx));
-        for (auto i = idx; i < m_items.size(); i++) {
-            m_map.insert_or_assign(ItemTrait<T>::key(m_items.at(i)), i);
+        // existing keys update in place, new ones append and rotate to idx
+        auto old = m_items.size();
+        for (auto&& el : forward_range<U>(range)) {
+            auto k = ItemTrait<T>::key(el);
+            if (auto pos = m_index.index_of(k)) {
+                m_items.at(*pos) = std::forward<decltype(el)>(el);
+            } else {
+                m_index.insert(m_items.size(), std::views::single(k));
+                m_items.emplace_back(std::forward<decltype(el)>(el));
+            }
+        }
+        if (idx < old && old < m_items.size()) {
+            auto it = m_items.begin();
+            std::rotate(it + idx, it + old, m_items.end());
+            m_index.move(old, idx, m_items.size() - old);
         }
     }
 
+    // the key of val is in no other row
+    template<typename V>
+    void _assign_impl(usize row, V&& val) {
+        auto& item = m_items.at(row);
+        if (auto k = ItemTrait<T>::key(val); k != ItemTrait<T>::key(item)) {
+            m_index.erase(row, row + 1);
+            m_index.insert(row, std::views::single(k));
+        }
+        item = std::forward<V>(val);
+    }
+
     void _erase_impl(usize idx, usize last) {
         auto it = m_items.begin();
-        for (auto i = idx; i < last; i++) {
-            m_map.erase(ItemTrait<T>::key(m_items.at(i)));
-        }
         m_items.erase(it + idx, it + last);
+        m_index.erase(idx, last);
     }
 
     void _reset_impl() {
         m_items.clear();
-        m_map.clear();
+        m_index.clear();
     }
 
     template<std::ranges::range U>
     void _reset_impl(U&& items) {
         m_items.clear();
-        m_map.clear();
+        m_index.clear();
         _insert_impl(0, std::forward<U>(items));
     }
 
@@ -383,35 +716,36 @@ protected:
         auto dst = it + destinationRow;
         if (sourceRow > destinationRow) {
             std::rotate(dst, src, src + count);
-            for (auto i = destinationRow; i < sourceRow + count; i++) {
-                m_map.insert_or_assign(ItemTrait<T>::key(m_items.at(i)), i);
-            }
         } else {
             std::rotate(src, src + count, dst);
-            for (auto i = sourceRow; i < destinationRow; i++) {
-                m_map.insert_or_assign(ItemTrait<T>::key(m_items.at(i)), i);
-            }
         }
+        m_index.move(sourceRow, destinationRow, count);
     }
 
-    auto& _maps() { return m_map; }
+    void _swap_impl(ListImpl& o) noexcept {
+        m_index.swap(o.m_index);
+        m_items.swap(o.m_items);
+    }
 
 private:
-    // indexed cache with hash
-    HashMap<key_type, usize, allocator_type> m_map;
-    container_type                           m_items;
+    // row of key
+    OrderIndex<key_type, allocator_type> m_index;
+    container_type                       m_items;
 };
+
+///
+/// @brief rows in a HashMap by key, ordered by a key list
+/// items move when the map grows, a pointer from query or a reference from at
+/// is invalidated by any insert, as with Vector
 template<typename T, typename Allocator>
 class ListImpl<T, Allocator, QMetaListStore::Map> {
 public:
     using allocator_type = Allocator;
     using key_type       = ItemTrait<T>::key_type;
-    using container_type =
-        std::unordered_map<key_type, T, std::hash<key_type>, std::equal_to<key_type>,
-                           detail::rebind_alloc<Allocator, std::pair<const key_type, T>>>;
-    using iterator = container_type::iterator;
+    using container_type = HashMap<key_type, T, Allocator>;
+    using iterator       = container_type::iterator;
 
-    ListImpl(Allocator allc = Allocator()): m_order(allc), m_items(allc) {}
+    ListImpl(Allocator allc = Allocator()): m_order(allc), m_items(allc), m_index(allc) {}
 
     auto        begin() const { return std::begin(m_items); }
     auto        end() const { return std::end(m_items); }
@@ -427,12 +761,10 @@ public:
     auto key_at(usize idx) const { return m_order.at(idx); }
 
     auto query_idx(param_type<key_type> key) const -> std::optional<usize> {
-        if (auto it = std::find(m_order.begin(), m_order.end(), key); it != m_order.end()) {
-            return std::distance(m_order.begin(), it);
-        }
-        return std::nullopt;
+        return m_index.index_of(key);
     };
 
+    // valid until the next insert
     T* query(param_type<key_type> key) {
         if (auto it = m_items.find(key); it != m_items.end()) return std::addressof(it->second);
         return nullptr;
@@ -445,7 +777,7 @@ public:
 protected:
     template<std::ranges::sized_range U>
     auto _insert_len(U&& range) {
-        auto view = std::views::transform(range, [this](auto& el) -> usize {
+        auto view = std::views::transform(range, [this](const auto& el) -> usize {
             return m_items.contains(ItemTrait<T>::key(el)) ? 0 : 1;
         });
         return std::accumulate(view.begin(), view.end(), 0);
@@ -455,12 +787,26 @@ protected:
     void _insert_impl(usize it, U&& range) {
         std::vector<key_type, detail::rebind_alloc<allocator_type, key_type>> order(
             get_allocator());
-        for (auto&& el : std::forward<U>(range)) {
+        for (auto&& el : forward_range<U>(range)) {
             auto k = ItemTrait<T>::key(el);
-            order.emplace_back(k);
+            if (! m_items.contains(k)) order.emplace_back(k);
             m_items.insert_or_assign(k, std::forward<decltype(el)>(el));
         }
         m_order.insert(m_order.begin() + it, order.begin(), order.end());
+        m_index.insert(it, order);
+    }
+
+    // the key of val is in no other row
+    template<typename V>
+    void _assign_impl(usize row, V&& val) {
+        auto k = ItemTrait<T>::key(val);
+        if (auto& old = m_order.at(row); k != old) {
+            m_items.erase(old);
+            old = k;
+            m_index.erase(row, row + 1);
+            m_index.insert(row, std::views::single(k));
+        }
+        m_items.insert_or_assign(k, std::forward<V>(val));
     }
 
     void _erase_impl(usize index, usize last) {
@@ -471,17 +817,20 @@ protected:
             m_items.erase(*it);
         }
         m_order.erase(it + index, it + last);
+        m_index.erase(index, last);
     }
 
     void _reset_impl() {
         m_items.clear();
         m_order.clear();
+        m_index.clear();
     }
 
     template<std::ranges::range U>
     void _reset_impl(U&& items) {
         m_order.clear();
         m_items.clear();
+        m_index.clear();
         _insert_impl(0, std::forward<U>(items));
     }
 
@@ -494,11 +843,21 @@ protected:
         } else {
             std::rotate(src, src + count, dst);
         }
+        m_index.move(sourceRow, destinationRow, count);
+    }
+
+    void _swap_impl(ListImpl& o) noexcept {
+        using std::swap;
+        m_order.swap(o.m_order);
+        swap(m_items, o.m_items);
+        m_index.swap(o.m_index);
     }
 
 private:
     std::vector<key_type, detail::rebind_alloc<allocator_type, key_type>> m_order;
     container_type                                                        m_items;
+    // row of key
+    OrderIndex<key_type, allocator_type> m_index;
 };
 
 template<typename T, typename Allocator>
@@ -508,18 +867,18 @@ public:
     using allocator_type = Allocator;
     using key_type       = ItemTrait<T>::key_type;
     using store_type     = ItemTrait<T>::store_type;
-    using container_type =
-        std::unordered_map<key_type, T, std::hash<key_type>, std::equal_to<key_type>,
-                           detail::rebind_alloc<Allocator, std::pair<const key_type, T>>>;
-    using iterator = container_type::iterator;
+    using container_type = HashMap<key_type, T, Allocator>;
+    using iterator       = container_type::iterator;
 
     ListImpl(Allocator allc = Allocator())
         : m_order(allc),
+          m_index(allc),
           m_view(std::views::transform(m_order, Trans { this })),
           m_notify_handle(0) {}
 
     ~ListImpl() {
-        m_store->store_unreg_notify(m_notify_handle);
+        if (! m_store) return;
+        if (m_notify_handle) m_store->store_unreg_notify(m_notify_handle);
         _reset_impl();
     }
 
@@ -534,37 +893,38 @@ public:
     auto        get_allocator() const { return m_order.get_allocator(); }
 
     // hash
-    bool contains(param_type<T> t) const { return m_map.contains(ItemTrait<T>::key(t)); }
+    bool contains(param_type<T> t) const { return m_index.contains(ItemTrait<T>::key(t)); }
     auto key_at(usize idx) const { return m_order.at(idx); }
 
     auto query_idx(param_type<key_type> key) const -> std::optional<usize> {
-        if (auto it = m_map.find(key); it != m_map.end()) return it->second;
-        return std::nullopt;
+        return m_index.index_of(key);
     }
     T*       query(param_type<key_type> key) { return m_store->store_query(key); }
     T const* query(param_type<key_type> key) const { return m_store->store_query(key); }
 
-    void set_store(QAbstractListModel* self, store_type store) {
+    void set_store(QMetaListModelBase* self, store_type store) {
         m_store = store;
 
         // TODO: no void*
         auto list       = QPointer { self };
-        m_notify_handle = m_store->store_reg_notify([list, this](std::span<const key_type> keys) {
-            if (! list) return;
-            for (auto& key : keys) {
-                if (auto it = m_map.find(key); it != m_map.end()) {
-                    auto idx = list->index(it->second);
-                    list->dataChanged(idx, idx);
+        m_notify_handle = m_store->store_reg_notify(
+            [list, this](std::span<const key_type> keys, std::span<const FieldMask> fields) {
+                if (! list) return;
+                QMetaListModelBase::UpdateGuard guard { *list };
+                for (usize i = 0; i < keys.size(); i++) {
+                    if (auto row = m_index.index_of(keys[i])) {
+                        list->notifyDataChanged(*row, *row, field_roles(fields[i]));
+                    }
                 }
-            }
-        });
+            },
+            true);
     }
 
 protected:
     template<std::ranges::sized_range U>
     auto _insert_len(U&& range) {
-        auto view = std::views::transform(range, [this](auto& el) -> usize {
-            return m_map.contains(ItemTrait<T>::key(el)) ? 0 : 1;
+        auto view = std::views::transform(range, [this](const auto& el) -> usize {
+            return m_index.contains(ItemTrait<T>::key(el)) ? 0 : 1;
         });
         return std::accumulate(view.begin(), view.end(), 0);
     }
@@ -573,12 +933,12 @@ protected:
     void _insert_impl(usize it, U&& range) {
         std::vector<key_type, detail::rebind_alloc<allocator_type, key_type>> order(
             get_allocator());
-        for (auto&& el : std::forward<U>(range)) {
+        for (auto&& el : forward_range<U>(range)) {
             auto k = ItemTrait<T>::key(el);
-            if (m_map.contains(k)) {
+            if (m_index.contains(k)) {
                 m_store->store_insert(std::forward<decltype(el)>(el), false, m_notify_handle);
             } else {
-                m_map.insert({ k, it + order.size() });
+                m_index.insert(it + order.size(), std::views::single(k));
                 order.emplace_back(k);
                 m_store->store_insert(std::forward<decltype(el)>(el), true, m_notify_handle);
             }
@@ -586,31 +946,48 @@ protected:
         m_order.insert(m_order.begin() + it, order.begin(), order.end());
     }
 
+    // the key of val is in no other row
+    template<typename V>
+    void _assign_impl(usize row, V&& val) {
+        auto k   = ItemTrait<T>::key(val);
+        auto old = m_order.at(row);
+        if (k == old) {
+            m_store->store_insert(std::forward<V>(val), false, m_notify_handle);
+            return;
+        }
+        // hold the new key before releasing the old one
+        m_store->store_insert(std::forward<V>(val), true, m_notify_handle);
+        m_store->store_remove(old, m_notify_handle);
+        m_order.at(row) = k;
+        m_index.erase(row, row + 1);
+        m_index.insert(row, std::views::single(k));
+    }
+
     void _erase_impl(usize index, usize last) {
         auto it    = m_order.begin();
         auto begin = it + index;
         auto end   = it + last;
         for (auto it = begin; it != end; it++) {
-            m_map.erase(*it);
-            m_store->store_remove(*it);
+            m_store->store_remove(*it, m_notify_handle);
         }
         m_order.erase(it + index, it + last);
+        m_index.erase(index, last);
     }
 
     void _reset_impl() {
         for (auto& k : m_order) {
-            m_store->store_remove(k);
+            m_store->store_remove(k, m_notify_handle);
         }
-        m_map.clear();
+        m_index.clear();
         m_order.clear();
     }
 
     template<std::ranges::range U>
     void _reset_impl(U&& items) {
         for (auto& k : m_order) {
-            m_store->store_remove(k);
+            m_store->store_remove(k, m_notify_handle);
         }
-        m_map.clear();
+        m_index.clear();
         m_order.clear();
         _insert_impl(0, std::forward<U>(items));
     }
@@ -621,17 +998,45 @@ protected:
         auto dst = it + destinationRow;
         if (sourceRow > destinationRow) {
             std::rotate(dst, src, src + count);
-            for (auto i = destinationRow; i < sourceRow + count; i++) {
-                m_map.insert_or_assign(m_order.at(i), i);
-            }
         } else {
             std::rotate(src, src + count, dst);
-            for (auto i = sourceRow; i < destinationRow; i++) {
-                m_map.insert_or_assign(m_order.at(i), i);
-            }
         }
+        m_index.move(sourceRow, destinationRow, count);
+    }
+
+    // keys are counted in the same store by both, notify handles stay
+    // and keep their subscriptions, see _swap_rows
+    void _swap_impl(ListImpl& o) noexcept {
+        Q_ASSERT(! m_store || ! o.m_store || *m_store == *o.m_store);
+        if (! m_store) m_store = o.m_store;
+        if (! o.m_store) o.m_store = m_store;
+        m_order.swap(o.m_order);
+        m_index.swap(o.m_index);
     }
 
+    // swap rows with o, each notify handle follows the rows it holds after
+    // store thread only
+    void _swap_rows(ListImpl& o) {
+        _swap_impl(o);
+        if (! m_store) return;
+        auto& store = *m_store;
+        // rows of a snapshot built on another thread may be queued in the store
+        if constexpr (requires { store.sync(); }) store.sync();
+
+        auto move_subs = [&store](auto& keys, std::int64_t from, std::int64_t to) {
+            if (from == to) return;
+            for (auto& k : keys) store.store_resubscribe(k, from, to);
+        };
+        // rows are swapped already, o holds the old rows of this
+        move_subs(o.m_order, m_notify_handle, 0);
+        move_subs(m_order, o.m_notify_handle, 0);
+        move_subs(m_order, 0, m_notify_handle);
+        move_subs(o.m_order, 0, o.m_notify_handle);
+    }
+
+    // store without notify, for a snapshot
+    void _use_store(store_type store) { m_store = std::move(store); }
+
 private:
     struct Trans {
         ListImpl* self;
@@ -640,7 +1045,7 @@ private:
     };
 
     std::vector<key_type, detail::rebind_alloc<allocator_type, key_type>> m_order;
-    HashMap<key_type, usize, allocator_type>                              m_map;
+    OrderIndex<key_type, allocator_type>                                  m_index;
 
     std::ranges::transform_view<std::ranges::ref_view<decltype(m_order)>, Trans> m_view;
 
@@ -648,6 +1053,168 @@ private:
     std::optional<store_type> m_store;
 };
 
+///
+/// @brief rows [0, size) read from a provider in blocks, on first access
+/// keeps at most max_blocks blocks, dropping the least recently used
+/// a reference from at stays valid until its block is dropped
+/// rows are read only, change the source and resetModel(size)
+template<typename T, typename Allocator>
+class ListImpl<T, Allocator, QMetaListStore::Lazy> {
+public:
+    using allocator_type = Allocator;
+    using container_type = std::vector<T, Allocator>;
+    using iterator       = container_type::iterator;
+    // append count items of rows [offset, offset + count) to out
+    using provider_type = std::function<void(usize offset, usize count, container_type& out)>;
+
+    ListImpl(Allocator allc = Allocator())
+        : m_blocks(allc),
+          m_lru(allc),
+          m_size(0),
+          m_block_size(256),
+          m_max_blocks(16),
+          m_loads(0),
+          m_last(nullptr),
+          m_last_idx(0) {}
+
+    auto size() const { return m_size; }
+    auto at(usize idx) const -> const T& {
+        if (idx >= m_size) throw std::out_of_range("lazy list index out of range");
+        return block(idx / m_block_size).items.at(idx % m_block_size);
+    }
+    auto get_allocator() const { return m_lru.get_allocator(); }
+
+    ///
+    /// @brief set where rows come from, resetModel(size) to show them
+    void set_provider(provider_type provider, usize block_size = 256, usize max_blocks = 16) {
+        m_provider   = std::move(provider);
+        m_block_size = std::max<usize>(block_size, 1);
+        m_max_blocks = std::max<usize>(max_blocks, 1);
+        drop_blocks();
+    }
+    auto block_size() const -> usize { return m_block_size; }
+    auto cached_blocks() const -> usize { return m_blocks.size(); }
+    ///
+    /// @brief provider calls so far
+    auto block_loads() const -> usize { return m_loads; }
+
+protected:
+    void _reset_impl() { _reset_impl(0); }
+    void _reset_impl(usize size) {
+        drop_blocks();
+        m_size = size;
+    }
+
+private:
+    using lru_type = std::list<usize, rebind_alloc<Allocator, usize>>;
+    struct Block {
+        container_type              items;
+        typename lru_type::iterator lru;
+    };
+
+    auto block(usize idx) const -> const Block& {
+        // rows are mostly read in runs, skip the lookup for the same block
+        if (m_last && m_last_idx == idx) return *m_last;
+        auto it = m_blocks.find(idx);
+        if (it != m_blocks.end()) {
+            m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+        } else {
+            it = load(idx);
+        }
+        m_last     = &it->second;
+        m_last_idx = idx;
+        return *m_last;
+    }
+
+    auto load(usize idx) const {
+        // reuse the storage of the dropped block
+        container_type items(m_lru.get_allocator());
+        if (m_blocks.size() >= m_max_blocks) {
+            auto old = m_blocks.find(m_lru.back());
+            items    = std::move(old->second.items);
+            items.clear();
+            m_lru.pop_back();
+            m_blocks.erase(old);
+        }
+        auto offset = idx * m_block_size;
+        auto count  = std::min(m_block_size, m_size - offset);
+        items.reserve(count);
+        if (m_provider) m_provider(offset, count, items);
+        ++m_loads;
+        Q_ASSERT(items.size() == count);
+
+        m_lru.push_front(idx);
+        return m_blocks.try_emplace(idx, Block { std::move(items), m_lru.begin() }).first;
+    }
+
+    void drop_blocks() {
+        m_blocks.clear();
+        m_lru.clear();
+        m_last = nullptr;
+    }
+
+    mutable HashMap<usize, Block, Allocator> m_blocks;
+    mutable lru_type                         m_lru;
+    provider_type                            m_provider;
+    usize                                    m_size;
+    usize                                    m_block_size;
+    usize                                    m_max_blocks;
+    mutable usize                            m_loads;
+    mutable const Block*                     m_last;
+    mutable usize                            m_last_idx;
+};
+
+///
+/// @brief rows of a model built apart from it, e.g. on a worker thread
+/// holds the same containers and indexes as the model, which
+/// QMetaListModel::swap_snapshot takes over in O(1); build it with the
+/// allocator of the model
+/// a Share snapshot inserts its items into the store while building, off the
+/// store thread that needs ConcurrentShareStore
+template<typename T, typename Allocator, QMetaListStore Store>
+class ListSnapshot : public ListImpl<T, Allocator, Store> {
+    static_assert(Store != QMetaListStore::Lazy, "lazy rows come from their provider");
+    using base_type = ListImpl<T, Allocator, Store>;
+
+public:
+    ListSnapshot(Allocator alloc = Allocator()): base_type(alloc) {}
+
+    template<std::ranges::sized_range U>
+        requires(Store != QMetaListStore::Share)
+    ListSnapshot(U&& items, Allocator alloc = Allocator()): base_type(alloc) {
+        this->_reset_impl(std::forward<U>(items));
+    }
+
+    template<typename S, std::ranges::sized_range U>
+        requires(Store == QMetaListStore::Share)
+    ListSnapshot(S store, U&& items, Allocator alloc = Allocator()): base_type(alloc) {
+        this->_use_store(std::move(store));
+        this->_reset_impl(std::forward<U>(items));
+    }
+
+    ListSnapshot(ListSnapshot&& o) noexcept: base_type(o.get_allocator()) { this->_swap_impl(o); }
+    ListSnapshot& operator=(ListSnapshot&& o) noexcept {
+        this->_swap_impl(o);
+        return *this;
+    }
+
+    ///
+    /// @brief rows in order, moved out unless they live in a store
+    auto take_rows() -> std::vector<T, rebind_alloc<Allocator, T>> {
+        std::vector<T, rebind_alloc<Allocator, T>> out(this->get_allocator());
+        out.reserve(this->size());
+        for (usize i = 0; i < this->size(); i++) {
+            if constexpr (Store == QMetaListStore::Share) {
+                out.push_back(this->at(i));
+            } else {
+                out.push_back(std::move(this->at(i)));
+            }
+        }
+        this->_reset_impl();
+        return out;
+    }
+};
+
 } // namespace detail
 
 template<typename TItem, typename CRTP, QMetaListStore Store,
@@ -662,109 +1229,119 @@ public:
     using allocator_type = Allocator;
     using container_type = base_impl_type::container_type;
     using iterator       = container_type::iterator;
+    using snapshot_type  = detail::ListSnapshot<TItem, Allocator, Store>;
 
     template<typename T>
     using rebind_alloc = detail::rebind_alloc<allocator_type, T>;
 
     QMetaListModel(QObject* parent = nullptr, Allocator allc = Allocator())
-        : base_type(parent), base_impl_type(allc) {}
+        : base_type(parent), base_impl_type(allc), m_sync_reset_ratio(0) {}
     virtual ~QMetaListModel() {}
 
+    ///
+    /// @brief take the rows of snapshot in O(1), inside one reset
+    /// snapshot gets the old rows, e.g. to drop them on a worker thread
+    /// Share moves the notify subscription of each row, in O(n)
+    void swap_snapshot(snapshot_type& snapshot) {
+        Q_ASSERT(this->get_allocator() == snapshot.get_allocator());
+        this->beginResetModel();
+        if constexpr (Store == QMetaListStore::Share) {
+            this->_swap_rows(snapshot);
+        } else {
+            this->_swap_impl(snapshot);
+        }
+        this->bumpRowsVersion();
+        this->endResetModel();
+    }
+
+    ///
+    /// @brief apply the rows of snapshot with sync instead of a reset
+    /// views keep their state, the diff runs on this thread
+    void sync_snapshot(snapshot_type&& snapshot)
+        requires hashable_item<TItem>
+    {
+        sync(snapshot.take_rows());
+    }
+
+    ///
+    /// @brief sync falls back to reset when the edit script has more operations
+    /// than ratio * row count, 0 to never reset
+    void set_sync_reset_ratio(double ratio) { m_sync_reset_ratio = ratio; }
+    auto sync_reset_ratio() const -> double { return m_sync_reset_ratio; }
+
     ///
     /// @brief sync items without reset
-    /// if mostly changed, use reset
+    /// applies a minimal edit script of batched removes, moves and inserts
     template<detail::syncable_list<TItem> U>
     void sync(U&& items) {
-        using key_type     = ItemTrait<TItem>::key_type;
-        using idx_map_type = detail::HashMap<key_type, usize, allocator_type>;
+        using key_type = ItemTrait<TItem>::key_type;
 
-        auto changed = [this](int row, int count = 1) {
-            auto idx = this->index(row);
-            if (count > 1) {
-                auto end = this->index(row + count - 1);
-                this->dataChanged(idx, end);
-            } else {
-                this->dataChanged(idx, idx);
-            }
+        auto old_keys = row_keys(this->get_allocator());
+        std::vector<key_type, rebind_alloc<key_type>> new_keys(this->get_allocator());
+        new_keys.reserve(items.size());
+        for (auto& el : items) {
+            new_keys.emplace_back(ItemTrait<TItem>::key(el));
+        }
+
+        auto plan = detail::plan_sync<key_type>(old_keys, new_keys, this->get_allocator());
+        apply_plan(plan, std::forward<U>(items));
+    }
+
+    ///
+    /// @brief keys of the rows now, to plan a sync on another thread
+    /// the planning thread may free the keys, so alloc is not the model allocator,
+    /// which can be a pmr resource or arena that is not thread safe
+    template<typename KeyAllocator = std::allocator<TItem>>
+    auto sync_keys(KeyAllocator alloc = KeyAllocator()) const
+        requires hashable_item<TItem>
+    {
+        using key_type  = ItemTrait<TItem>::key_type;
+        using keys_type = typename SyncKeys<key_type, KeyAllocator>::keys_type;
+        return SyncKeys<key_type, KeyAllocator> {
+            this->rowsVersion(), std::make_shared<const keys_type>(row_keys(alloc))
         };
+    }
 
-        // update and remove
-        if constexpr (Store == QMetaListStore::Vector) {
-            // get key to idx map
-            idx_map_type key_to_idx(this->get_allocator());
-            key_to_idx.reserve(items.size());
-            for (decltype(items.size()) i = 0; i < items.size(); ++i) {
-                key_to_idx.insert({ ItemTrait<TItem>::key(items[i]), i });
-            }
-            for (usize i = 0; i < this->size();) {
-                auto key = ItemTrait<TItem>::key(this->at(i));
-                if (auto it = key_to_idx.find(key); it != key_to_idx.end()) {
-                    this->at(i) = std::forward<U>(items)[it->second];
-                    changed(it->second);
-                    key_to_idx.erase(it);
-                    ++i;
-                } else {
-                    this->remove(i);
-                }
-            }
-        } else if constexpr (Store == QMetaListStore::Map || Store == QMetaListStore::Share ||
-                             Store == QMetaListStore::VectorWithMap) {
-            auto item_size = (usize)items.size();
-            for (usize i = 0; i < item_size; i++) {
-                auto key = ItemTrait<TItem>::key(items[i]);
-                if (i < this->size()) {
-                    auto cur_key = this->key_at(i);
-                    if (key == cur_key) {
-                        // do update
-                        this->at(i) = std::forward<U>(items)[i];
-                        changed(i);
-                    } else {
-                        if (auto idx = this->query_idx(key)) {
-                            // try move more
-                            usize j = 1;
-                            for (; i + j < item_size && *idx + j < this->size(); j++) {
-                                auto key = ItemTrait<TItem>::key(items[i + j]);
-                                if (key != this->key_at(*idx + j)) {
-                                    break;
-                                }
-                            }
-                            // do move
-                            auto ok = this->move(*idx, i, 1 + (j - 1));
-                            Q_ASSERT(ok);
-                            Q_ASSERT(key == this->key_at(i));
-                            Q_ASSERT(cur_key == this->key_at(i + 1 + (j - 1)));
-
-                            // do update
-                            for (usize k = 0; k < j; k++) {
-                                this->at(i + k) = std::forward<U>(items)[i + k];
-                            }
-                            changed(i, j);
-                        } else {
-                            // do remove and insert
-                            this->remove(i);
-                            this->insert(i, std::forward<U>(items)[i]);
-                        }
-                    }
-                } else {
-                    // do and insert
-                    this->insert(i, std::forward<U>(items)[i]);
-                }
-            }
-            if (item_size < this->size()) {
-                // do remove
-                this->remove(item_size, this->size() - item_size);
-            }
+    ///
+    /// @brief plan the sync from keys to items, on any thread
+    /// the model is not touched, hand the result to apply on the model thread
+    template<typename K, typename KeyAllocator, detail::syncable_list<TItem> U>
+    static auto plan_sync(const SyncKeys<K, KeyAllocator>& keys, U&& items,
+                          Allocator alloc = Allocator()) -> PlannedSync<TItem, Allocator> {
+        PlannedSync<TItem, Allocator> out(alloc);
+        out.version = keys.version;
+        out.items.reserve(items.size());
+        for (auto&& el : detail::forward_range<U>(items)) {
+            out.items.emplace_back(std::forward<decltype(el)>(el));
+        }
+        std::vector<K, rebind_alloc<K>> new_keys(alloc);
+        new_keys.reserve(out.items.size());
+        for (auto& el : out.items) {
+            new_keys.emplace_back(ItemTrait<TItem>::key(el));
         }
+        out.plan = detail::plan_sync<K>(*keys.keys, new_keys, alloc);
+        return out;
     }
 
     ///
-    /// @brief sync items without reset
-    /// if mostly changed, use reset
+    /// @brief apply a sync planned by plan_sync
+    /// items are applied either way
+    /// @return false if items reset the model instead: rows changed since sync_keys,
+    /// or the plan is a reset or over the sync reset ratio
+    auto apply(PlannedSync<TItem, Allocator>&& planned) -> bool {
+        if (planned.version != this->rowsVersion()) {
+            this->resetModel(std::move(planned.items));
+            return false;
+        }
+        return apply_plan(planned.plan, std::move(planned.items));
+    }
+
+    ///
+    /// @brief update existing items and append new ones in one insert
     /// @return increased size
     template<detail::syncable_list<TItem> U>
     auto extend(U&& items) -> usize {
         using key_type     = ItemTrait<TItem>::key_type;
-        using idx_set_type = detail::Set<usize, allocator_type>;
         using idx_map_type = detail::HashMap<key_type, usize, allocator_type>;
 
         // get key to idx map
@@ -773,49 +1350,97 @@ public:
         for (decltype(items.size()) i = 0; i < items.size(); ++i) {
             key_to_idx.insert({ ItemTrait<TItem>::key(items[i]), i });
         }
-        auto changed = [this](int row) {
-            auto idx = this->index(row);
-            this->dataChanged(idx, idx);
-        };
+        typename base_type::UpdateGuard guard { *this };
 
         // update
-        if constexpr (Store == QMetaListStore::Vector) {
+        if constexpr (Store == QMetaListStore::Vector || Store == QMetaListStore::Chunked) {
             for (usize i = 0; i < this->size(); ++i) {
                 auto key = ItemTrait<TItem>::key(this->at(i));
                 if (auto it = key_to_idx.find(key); it != key_to_idx.end()) {
-                    this->at(i) = std::forward<U>(items)[it->second];
-                    changed(i);
+                    this->assignRow(i, detail::forward_element<U>(items[it->second]));
                     key_to_idx.erase(it);
                 }
             }
-        } else if constexpr (Store == QMetaListStore::VectorWithMap) {
-            for (auto& el : this->_maps()) {
-                if (auto it = key_to_idx.find(el.first); it != key_to_idx.end()) {
-                    this->at(el.second) = std::forward<U>(items)[it->second];
-                    changed(el.second);
-                    key_to_idx.erase(it);
-                }
-            }
-        } else if constexpr (Store == QMetaListStore::Map || Store == QMetaListStore::Share) {
-            for (usize i = 0; i < this->size(); ++i) {
-                auto h = this->key_at(i);
-                if (auto it = key_to_idx.find(h); it != key_to_idx.end()) {
-                    this->at(i) = std::forward<U>(items)[it->second];
-                    changed(i);
-                    key_to_idx.erase(it);
+        } else if constexpr (Store == QMetaListStore::Map || Store == QMetaListStore::Share ||
+                             Store == QMetaListStore::VectorWithMap) {
+            for (auto it = key_to_idx.begin(); it != key_to_idx.end();) {
+                if (auto row = this->query_idx(it->first)) {
+                    this->assignRow(*row, detail::forward_element<U>(items[it->second]));
+                    it = key_to_idx.erase(it);
+                } else {
+                    ++it;
                 }
             }
         }
 
-        // append new
-        idx_set_type ids(this->get_allocator());
+        // append new, in items order
+        std::vector<usize, rebind_alloc<usize>> ids(this->get_allocator());
+        ids.reserve(key_to_idx.size());
         for (auto& el : key_to_idx) {
-            ids.insert(el.second);
-        }
-        for (auto id : ids) {
-            this->insert(this->size(), std::forward<U>(items)[id]);
+            ids.push_back(el.second);
         }
+        std::ranges::sort(ids);
+        this->insert(this->size(), std::views::transform(ids, [&items](usize id) -> decltype(auto) {
+                         return detail::forward_element<U>(items[id]);
+                     }));
         return ids.size();
     }
+
+private:
+    template<typename A>
+    auto row_keys(A alloc) const {
+        using key_type = ItemTrait<TItem>::key_type;
+        std::vector<key_type, detail::rebind_alloc<A, key_type>> keys(alloc);
+        keys.reserve(this->size());
+        for (usize i = 0; i < this->size(); i++) {
+            if constexpr (Store == QMetaListStore::Vector || Store == QMetaListStore::Chunked) {
+                keys.emplace_back(ItemTrait<TItem>::key(this->at(i)));
+            } else {
+                keys.emplace_back(this->key_at(i));
+            }
+        }
+        return keys;
+    }
+
+    // false if it reset instead
+    template<typename A, typename U>
+    bool apply_plan(const detail::SyncPlan<A>& plan, U&& items) {
+        auto rows = std::max<usize>(this->size(), items.size());
+        if (plan.reset ||
+            (m_sync_reset_ratio > 0 && plan.ops.size() > m_sync_reset_ratio * rows)) {
+            this->resetModel(std::forward<U>(items));
+            return false;
+        }
+
+        for (auto& op : plan.ops) {
+            switch (op.type) {
+            case detail::SyncOp::Type::Remove: {
+                this->remove(op.row, op.count);
+                break;
+            }
+            case detail::SyncOp::Type::Move: {
+                auto ok = this->move(op.row, op.dst, op.count);
+                Q_ASSERT(ok);
+                break;
+            }
+            case detail::SyncOp::Type::Insert: {
+                this->insert(op.row,
+                             detail::forward_range<U>(items, op.item, op.item + op.count));
+                break;
+            }
+            }
+        }
+        Q_ASSERT(this->size() == items.size());
+
+        typename base_type::UpdateGuard guard { *this };
+        for (auto& [begin, end] : plan.updates) {
+            for (auto i = begin; i < end; i++) {
+                this->assignRow(i, detail::forward_element<U>(items[i]));
+            }
+        }
+        return true;
+    }
+
+    double m_sync_reset_ratio;
 };
 } // namespace meta_model
\ No newline at end of file
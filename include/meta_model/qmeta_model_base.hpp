@@ -1,5 +1,9 @@
 #pragma once
 
+#include <memory>
+#include <optional>
+#include <vector>
+
 #include <QtCore/QObject>
 #include <QtCore/QHash>
 #include <QtCore/QMetaProperty>
@@ -14,46 +18,58 @@ struct Empty {
 namespace detail
 {
 
-void update_role_names(QHash<int, QByteArray>& role_names, const QMetaObject& meta);
-}
+///
+/// @brief role dispatch table of a QMetaObject
+/// role of property i is Qt::UserRole + 1 + i
+struct RoleTable {
+    static constexpr int first_role = Qt::UserRole + 1;
+
+    QHash<int, QByteArray>     role_names;
+    QHash<QByteArray, int>     name_roles;
+    std::vector<QMetaProperty> props;
+
+    auto property(int role) const -> const QMetaProperty* {
+        auto idx = role - first_role;
+        if (idx < 0 || idx >= (int)props.size()) return nullptr;
+        return &props[idx];
+    }
+};
+
+///
+/// @brief get the shared role table of meta, built once per process
+auto role_table(const QMetaObject& meta) -> std::shared_ptr<const RoleTable>;
+} // namespace detail
 
 template<typename T>
 class QMetaRoleNames {
 public:
-    QMetaRoleNames(): m_meta(Empty::staticMetaObject) {}
+    QMetaRoleNames()
+        : m_meta(Empty::staticMetaObject), m_role_table(detail::role_table(m_meta)) {}
 
     auto meta() const -> const QMetaObject& { return m_meta; }
     auto roleOf(QByteArrayView name) const -> int {
-        if (auto it = std::find_if(roleNamesRef().keyValueBegin(),
-                                   roleNamesRef().keyValueEnd(),
-                                   [name](const auto& el) -> bool {
-                                       return el.second == name;
-                                   });
-            it != roleNamesRef().keyValueEnd()) {
-            return it->first;
-        }
-        return -1;
+        return m_role_table->name_roles.value(QByteArray::fromRawData(name.data(), name.size()),
+                                              -1);
     }
 
 protected:
     void updateRoleNames(const QMetaObject& meta) {
         auto self = static_cast<T*>(this);
         self->layoutAboutToBeChanged();
-        m_meta = meta;
-        detail::update_role_names(m_role_names, m_meta);
+        m_meta       = meta;
+        m_role_table = detail::role_table(meta);
         self->layoutChanged();
     }
-    auto roleNamesRef() const -> const QHash<int, QByteArray>& { return m_role_names; }
+    auto roleNamesRef() const -> const QHash<int, QByteArray>& { return m_role_table->role_names; }
     auto propertyOfRole(int role) const -> std::optional<QMetaProperty> {
-        if (auto prop_idx = meta().indexOfProperty(roleNamesRef().value(role).constData());
-            prop_idx != -1) {
-            return meta().property(prop_idx);
+        if (auto prop = m_role_table->property(role)) {
+            return *prop;
         }
         return std::nullopt;
     }
 
-    QHash<int, QByteArray> m_role_names;
-    QMetaObject            m_meta;
+    QMetaObject                              m_meta;
+    std::shared_ptr<const detail::RoleTable> m_role_table;
 };
 
 template<typename TBase>
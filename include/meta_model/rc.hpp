@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 
 namespace meta_model
@@ -8,23 +9,23 @@ template<typename T>
 class Rc {
 public:
     Rc(): m_inner(nullptr) {}
-    ~Rc() {
-        if (m_inner) {
-            if (m_inner->decrease() == 0) {
-                delete m_inner;
-            }
-        }
+    ~Rc() { release(); }
+    Rc(const Rc& o) noexcept: m_inner(o.m_inner) {
+        if (m_inner) m_inner->increase();
     }
-    Rc(const Rc& o) noexcept: m_inner(o.m_inner) { m_inner->increase(); }
-    Rc(Rc& o) noexcept: m_inner(o.m_inner) { o.m_inner = nullptr; }
+    Rc(Rc&& o) noexcept: m_inner(o.m_inner) { o.m_inner = nullptr; }
     Rc& operator=(const Rc& o) noexcept {
+        if (o.m_inner) o.m_inner->increase();
+        release();
         m_inner = o.m_inner;
-        m_inner->increase();
         return *this;
     }
-    Rc& operator=(Rc& o) noexcept {
-        m_inner   = o.m_inner;
-        o.m_inner = nullptr;
+    Rc& operator=(Rc&& o) noexcept {
+        if (this != &o) {
+            release();
+            m_inner   = o.m_inner;
+            o.m_inner = nullptr;
+        }
         return *this;
     }
 
@@ -48,6 +49,70 @@ private:
             return count;
         }
     };
+
+    void release() noexcept {
+        if (m_inner && m_inner->decrease() == 0) {
+            delete m_inner->ptr;
+            delete m_inner;
+        }
+        m_inner = nullptr;
+    }
+
+    Inner* m_inner;
+};
+
+///
+/// @brief Rc with atomic count, copies may live on different threads
+template<typename T>
+class Arc {
+public:
+    Arc(): m_inner(nullptr) {}
+    ~Arc() { release(); }
+    Arc(const Arc& o) noexcept: m_inner(o.m_inner) {
+        if (m_inner) m_inner->count.fetch_add(1, std::memory_order_relaxed);
+    }
+    Arc(Arc&& o) noexcept: m_inner(o.m_inner) { o.m_inner = nullptr; }
+    Arc& operator=(const Arc& o) noexcept {
+        if (this != &o) {
+            if (o.m_inner) o.m_inner->count.fetch_add(1, std::memory_order_relaxed);
+            release();
+            m_inner = o.m_inner;
+        }
+        return *this;
+    }
+    Arc& operator=(Arc&& o) noexcept {
+        if (this != &o) {
+            release();
+            m_inner   = o.m_inner;
+            o.m_inner = nullptr;
+        }
+        return *this;
+    }
+
+    static auto create(T* t) {
+        auto arc    = Arc {};
+        arc.m_inner = new Inner { t, 1 };
+        return arc;
+    }
+
+    operator bool() const noexcept { return m_inner != nullptr; }
+    T*             operator->() const noexcept { return m_inner->ptr; }
+    constexpr bool operator==(const Arc& o) const { return m_inner == o.m_inner; }
+
+private:
+    struct Inner {
+        T*                       ptr;
+        std::atomic<std::size_t> count;
+    };
+
+    void release() noexcept {
+        if (m_inner && m_inner->count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete m_inner->ptr;
+            delete m_inner;
+        }
+        m_inner = nullptr;
+    }
+
     Inner* m_inner;
 };
 } // namespace meta_model
\ No newline at end of file
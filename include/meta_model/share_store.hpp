@@ -1,14 +1,20 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <list>
 #include <span>
 #include <functional>
 #include <map>
 #include <memory>
+#include <memory_resource>
+#include <vector>
 
 #include <QtCore/QObject>
 #include <QtCore/QPointer>
 #include <QtCore/QMetaObject>
 
+#include "meta_model/flat_map.hpp"
 #include "meta_model/item_trait.hpp"
 #include "meta_model/rc.hpp"
 
@@ -36,36 +42,129 @@ template<typename T>
 concept storeable_item = hashable_item<T> && requires(T t) { typename ItemTrait<T>::store_type; } &&
                          storeable<typename ItemTrait<T>::store_type, T>;
 
+///
+/// @brief set of item fields, bit i is the i-th Q_PROPERTY, i.e. role Qt::UserRole + 1 + i
+using FieldMask = std::uint64_t;
+
+inline constexpr FieldMask all_fields = ~FieldMask(0);
+
+namespace detail
+{
+template<typename T, std::size_t... I>
+auto copy_fields_impl(T& dst, const T& src, FieldMask mask, std::index_sequence<I...>)
+    -> FieldMask {
+    FieldMask changed = 0;
+    (
+        [&] {
+            using member_type = std::remove_cvref_t<decltype(std::get<I>(ItemTrait<T>::roles))>;
+            if constexpr (std::is_member_object_pointer_v<member_type>) {
+                constexpr auto p = std::get<I>(ItemTrait<T>::roles);
+                if (! (mask & (FieldMask(1) << I))) return;
+                if constexpr (std::equality_comparable<decltype(dst.*p)>) {
+                    if (dst.*p == src.*p) return;
+                }
+                dst.*p = src.*p;
+                changed |= FieldMask(1) << I;
+            }
+        }(),
+        ...);
+    return changed;
+}
+
+///
+/// @brief copy masked fields that are data members in ItemTrait::roles
+/// @return fields that changed
+template<typename T>
+auto copy_fields(T& dst, const T& src, FieldMask mask) -> FieldMask {
+    constexpr auto size = std::tuple_size_v<std::remove_cvref_t<decltype(ItemTrait<T>::roles)>>;
+    static_assert(size <= 64, "FieldMask holds 64 fields");
+    return copy_fields_impl(dst, src, mask, std::make_index_sequence<size> {});
+}
+} // namespace detail
+
+///
+/// @brief keep entries that lost their last reference, so store_item can revive them
+/// least recently released entries are evicted first, 0 disables a limit
+struct StoreRetention {
+    usize                     max_items { 0 };
+    usize                     max_bytes { 0 };
+    std::chrono::milliseconds ttl { 0 };
+
+    bool enabled() const { return max_items || max_bytes || ttl.count(); }
+};
+
+struct StoreRetentionStats {
+    // store_item revived a retained entry
+    usize hits { 0 };
+    // store_item found nothing
+    usize misses { 0 };
+    usize evictions { 0 };
+    usize retained { 0 };
+    usize retained_bytes { 0 };
+};
+
 template<typename T, typename Allocator = std::allocator<T>, typename TItemExtend = void,
          typename InnerCustom = std::int64_t>
 struct ShareStore;
 
+template<typename T, typename Allocator, usize Shards>
+struct ConcurrentShareStore;
+
+///
+/// @brief store that counts changes which may move or free its items
+/// a pointer from store_query stays valid while the generation is the same
+template<typename T>
+concept generational_store = requires(const T t) {
+    { t.store_generation() } -> std::same_as<std::uint64_t>;
+};
+
 template<typename T, typename Store>
 class StoreItem {
     using key_type = typename meta_model::ItemTrait<T>::key_type;
+    // generation of an empty cache
+    static constexpr std::uint64_t no_generation = ~std::uint64_t(0);
     template<typename, typename Allocator, typename TItemExtend, typename InnerCustom>
     friend struct ShareStore;
+    template<typename, typename Allocator, usize Shards>
+    friend struct ConcurrentShareStore;
 
-    StoreItem(Store s, key_type k): m_store(s), m_key(k) { Q_ASSERT(m_key); }
+    StoreItem(Store s, key_type k)
+        : m_store(s), m_key(k), m_ptr(nullptr), m_generation(no_generation) {
+        Q_ASSERT(m_key);
+    }
 
 public:
     StoreItem() = delete;
-    StoreItem(Store s): m_store(s) {}
+    StoreItem(Store s): m_store(s), m_ptr(nullptr), m_generation(no_generation) {}
 
-    StoreItem(const StoreItem& o): m_store(o.m_store), m_key(o.m_key) {
+    StoreItem(const StoreItem& o)
+        : m_store(o.m_store), m_key(o.m_key), m_ptr(o.m_ptr), m_generation(o.m_generation) {
         if (m_key) m_store.store_increase(*m_key);
     }
-    StoreItem(StoreItem&& o) noexcept: m_store(o.m_store), m_key(o.m_key) { o.m_key = {}; }
+    StoreItem(StoreItem&& o) noexcept
+        : m_store(o.m_store), m_key(o.m_key), m_ptr(o.m_ptr), m_generation(o.m_generation) {
+        o.m_key = {};
+    }
     StoreItem& operator=(const StoreItem& o) {
-        m_store = o.m_store;
-        m_key   = o.m_key;
-        if (m_key) m_store.store_increase(*m_key);
+        if (this == &o) return *this;
+        // hold the new key before releasing the old one, they may be the same
+        Store store = o.m_store;
+        if (o.m_key) store.store_increase(*o.m_key);
+        if (m_key) m_store.store_remove(*m_key);
+        m_store      = store;
+        m_key        = o.m_key;
+        m_ptr        = o.m_ptr;
+        m_generation = o.m_generation;
         return *this;
     }
     StoreItem& operator=(StoreItem&& o) noexcept {
-        m_store = o.m_store;
-        m_key   = o.m_key;
-        o.m_key = {};
+        if (this == &o) return *this;
+        if (m_key) m_store.store_remove(*m_key);
+        m_store      = o.m_store;
+        m_key        = o.m_key;
+        m_ptr        = o.m_ptr;
+        m_generation = o.m_generation;
+        o.m_key      = {};
         return *this;
     }
 
@@ -79,7 +178,7 @@ public:
 
     auto item() const -> T* { return store_query(); }
     auto operator*() const -> T& { return *store_query(); }
-    auto operator->() const -> T* { return *store_query(); }
+    auto operator->() const -> T* { return store_query(); }
     operator bool() const { return store_query() != nullptr; }
 
     auto key() const { return m_key; }
@@ -87,14 +186,24 @@ public:
 
 private:
     auto store_query() const -> T* {
-        if (m_key) {
+        if (! m_key) return nullptr;
+        if constexpr (generational_store<Store>) {
+            auto gen = m_store.store_generation();
+            if (gen != m_generation) {
+                m_ptr        = m_store.store_query(*m_key);
+                m_generation = gen;
+            }
+            return m_ptr;
+        } else {
             return m_store.store_query(*m_key);
         }
-        return nullptr;
     }
 
     Store                   m_store;
     std::optional<key_type> m_key;
+    // last store_query result, valid while the store generation is the same
+    mutable T*            m_ptr;
+    mutable std::uint64_t m_generation;
 };
 
 template<typename T, typename Allocator, typename TItemExtend, typename InnerCustom>
@@ -102,6 +211,9 @@ struct ShareStore {
     using handle_type     = std::int64_t;
     using key_type        = typename ItemTrait<T>::key_type;
     using callback_type   = std::function<void(std::span<const key_type>)>;
+    // changed keys with the fields changed on each
+    using field_callback_type =
+        std::function<void(std::span<const key_type>, std::span<const FieldMask>)>;
     using store_item_type = StoreItem<T, ShareStore>;
     using item_type       = T;
 
@@ -109,8 +221,28 @@ struct ShareStore {
     using rebind_alloc = typename std::allocator_traits<Allocator>::template rebind_alloc<U>;
     template<typename, typename>
     friend class StoreItem;
-    struct _Item {
-        _Item(T item, handle_type count): item(item), count(count) {}
+    // handles of filtered notify that hold the key
+    struct _Subscribers {
+        _Subscribers(const Allocator& alloc): subs(alloc) {}
+
+        std::vector<handle_type, rebind_alloc<handle_type>> subs;
+
+        void subscribe(handle_type h) {
+            if (std::find(subs.begin(), subs.end(), h) == subs.end()) subs.push_back(h);
+        }
+        void unsubscribe(handle_type h) { std::erase(subs, h); }
+    };
+
+    using lru_type = std::list<key_type, rebind_alloc<key_type>>;
+    // position in the retention list, while the count is 0
+    struct _Retained {
+        typename lru_type::iterator           lru_pos;
+        std::chrono::steady_clock::time_point released_at;
+    };
+
+    struct _Item : _Subscribers, _Retained {
+        _Item(T item, handle_type count, const Allocator& alloc)
+            : _Subscribers(alloc), item(std::move(item)), count(count) {}
 
         T           item;
         handle_type count;
@@ -118,8 +250,9 @@ struct ShareStore {
         auto        decrease() noexcept { return --count; }
     };
 
-    struct _ItemEx {
-        _ItemEx(T item, handle_type count): item(item), count(count), extend() {}
+    struct _ItemEx : _Subscribers, _Retained {
+        _ItemEx(T item, handle_type count, const Allocator& alloc)
+            : _Subscribers(alloc), item(std::move(item)), count(count), extend() {}
         ~_ItemEx()              = default;
         _ItemEx(const _ItemEx&) = default;
         _ItemEx(_ItemEx&&)      = default;
@@ -132,38 +265,210 @@ struct ShareStore {
         auto decrease() noexcept { return --count; }
     };
 
+    struct _Callback {
+        callback_type       fn;
+        field_callback_type field_fn;
+        // only keys subscribed through store_insert with this handle
+        bool filtered;
+
+        template<typename K, typename M>
+        void operator()(const K& keys, const M& fields) const {
+            if (field_fn) {
+                field_fn(keys, fields);
+            } else {
+                fn(keys);
+            }
+        }
+    };
+
+    struct _Pending {
+        // the handle that changed it, 0 if several
+        handle_type handle;
+        FieldMask   fields;
+    };
+
     using inner_item_type = std::conditional_t<std::same_as<void, TItemExtend>, _Item, _ItemEx>;
 
     struct Inner {
         Inner(Allocator alloc)
-            : map(alloc), callbacks(alloc), serial(0), event(new QObject { nullptr }) {}
+            : map(alloc),
+              callbacks(alloc),
+              pending(alloc),
+              lru(alloc),
+              suppressed(0),
+              generation(0),
+              serial(0),
+              flush_posted(false),
+              event(new QObject { nullptr }) {}
         ~Inner() { delete event; }
 
-        std::unordered_map<key_type, inner_item_type, std::hash<key_type>, std::equal_to<key_type>,
-                           rebind_alloc<std::pair<const key_type, inner_item_type>>>
-            map;
-        std::map<handle_type, callback_type, std::less<>,
-                 rebind_alloc<std::pair<const handle_type, callback_type>>>
-                    callbacks;
-        handle_type serial;
-        QObject*    event;
+        // StoreItem and store_query hand out item pointers
+        detail::StableHashMap<key_type, inner_item_type, Allocator> map;
+        std::map<handle_type, _Callback, std::less<>,
+                 rebind_alloc<std::pair<const handle_type, _Callback>>>
+            callbacks;
+        detail::HashMap<key_type, _Pending, Allocator> pending;
+        // released keys, most recent first
+        lru_type                                          lru;
+        StoreRetention                                    retention;
+        StoreRetentionStats                               stats;
+        // store_insert/store_patch calls skipped as unchanged
+        usize                                             suppressed;
+        // bumped when an item is freed, map values don't move otherwise
+        std::uint64_t                                     generation;
+        handle_type                                       serial;
+        bool                                              flush_posted;
+        QObject*                                          event;
 
         InnerCustom custom;
 
-        template<typename U>
-        void delay_callback(handle_type req_handle, U&& range) {
-            QMetaObject::invokeMethod(event, [this, req_handle, range, p = QPointer(event)] {
-                if (! p) return;
-                for (auto& el : callbacks) {
-                    if (el.first == req_handle) continue;
-                    el.second(range);
+        void delay_callback(handle_type req_handle, param_type<key_type> key,
+                            FieldMask fields = all_fields) {
+            auto [it, ok] = pending.try_emplace(key, _Pending { req_handle, fields });
+            if (! ok) {
+                if (it->second.handle != req_handle) it->second.handle = 0;
+                it->second.fields |= fields;
+            }
+            if (! flush_posted) {
+                flush_posted = true;
+                QMetaObject::invokeMethod(
+                    event,
+                    [this, p = QPointer(event)] {
+                        if (! p) return;
+                        flush();
+                    },
+                    Qt::QueuedConnection);
+            }
+        }
+
+        using map_iterator = typename decltype(map)::iterator;
+
+        static auto bytes_of(const T& item) -> usize {
+            if constexpr (sized_item<T>) {
+                return ItemTrait<T>::bytes(item);
+            } else {
+                return sizeof(T);
+            }
+        }
+
+        // count dropped to 0
+        void release(map_iterator it) {
+            if (! retention.enabled()) {
+                map.erase(it);
+                ++generation;
+                return;
+            }
+            lru.push_front(it->first);
+            it->second.lru_pos     = lru.begin();
+            it->second.released_at = std::chrono::steady_clock::now();
+            ++stats.retained;
+            stats.retained_bytes += bytes_of(it->second.item);
+            trim();
+        }
+
+        // count is 0 and about to rise
+        void revive(map_iterator it) {
+            lru.erase(it->second.lru_pos);
+            --stats.retained;
+            stats.retained_bytes -= bytes_of(it->second.item);
+        }
+
+        // a retained item changes in place, its bytes are counted again
+        void resize_begin(const inner_item_type& item) {
+            if constexpr (sized_item<T>) {
+                if (item.count == 0) stats.retained_bytes -= bytes_of(item.item);
+            }
+        }
+        // may evict the item
+        void resize_end(const inner_item_type& item) {
+            if constexpr (sized_item<T>) {
+                if (item.count == 0) {
+                    stats.retained_bytes += bytes_of(item.item);
+                    trim();
+                }
+            }
+        }
+
+        void evict(map_iterator it) {
+            revive(it);
+            map.erase(it);
+            ++generation;
+            ++stats.evictions;
+        }
+
+        bool expired(const inner_item_type& item) const {
+            return retention.ttl.count() &&
+                   std::chrono::steady_clock::now() - item.released_at >= retention.ttl;
+        }
+
+        void trim() {
+            while (! lru.empty()) {
+                auto it = map.find(lru.back());
+                if (! retention.enabled() ||
+                    (retention.max_items && stats.retained > retention.max_items) ||
+                    (retention.max_bytes && stats.retained_bytes > retention.max_bytes) ||
+                    expired(it->second)) {
+                    evict(it);
+                } else {
+                    break;
+                }
+            }
+        }
+
+        void flush() {
+            flush_posted = false;
+            if (pending.empty()) return;
+            auto changed = std::move(pending);
+            pending.clear();
+
+            // dispatch to subscribers of each key
+            using key_list_type   = std::vector<key_type, rebind_alloc<key_type>>;
+            using field_list_type = std::vector<FieldMask, rebind_alloc<FieldMask>>;
+            struct Changes {
+                key_list_type   keys;
+                field_list_type fields;
+
+                void push(param_type<key_type> k, FieldMask f) {
+                    keys.push_back(k);
+                    fields.push_back(f);
+                }
+            };
+            auto make_changes = [this] {
+                return Changes { key_list_type(map.get_allocator()),
+                                 field_list_type(map.get_allocator()) };
+            };
+            detail::HashMap<handle_type, Changes, Allocator> per_sub { map.get_allocator() };
+            for (auto& [key, p] : changed) {
+                if (auto it = map.find(key); it != map.end()) {
+                    for (auto h : it->second.subs) {
+                        if (h == p.handle) continue;
+                        per_sub.try_emplace(h, make_changes()).first->second.push(key, p.fields);
+                    }
                 }
-            });
+            }
+
+            auto all = make_changes();
+            for (auto& [h, cb] : callbacks) {
+                if (cb.filtered) {
+                    if (auto it = per_sub.find(h); it != per_sub.end()) {
+                        cb(it->second.keys, it->second.fields);
+                    }
+                    continue;
+                }
+                all.keys.clear();
+                all.fields.clear();
+                for (auto& [key, p] : changed) {
+                    if (p.handle != h) all.push(key, p.fields);
+                }
+                if (! all.keys.empty()) cb(all.keys, all.fields);
+            }
         }
     };
 
     Rc<Inner> inner;
 
+    // entries and their subscriptions use alloc, the Inner block itself is one
+    // global allocation per store
     ShareStore(Allocator alloc = Allocator {}): inner(Rc<Inner>::create(new Inner(alloc))) {}
 
     constexpr bool operator==(const ShareStore& o) const { return inner == o.inner; }
@@ -177,59 +482,167 @@ struct ShareStore {
         }
         return nullptr;
     }
-    auto store_insert(param_type<T> item, bool new_one = false, handle_type handle = 0)
+    auto store_insert(const T& item, bool new_one = false, handle_type handle = 0)
         -> store_item_type {
-        std::vector<key_type, rebind_alloc<key_type>> changed { get_allocator() };
-        auto                                          key = ItemTrait<T>::key(item);
+        return insert_impl(item, new_one, handle);
+    }
+    auto store_insert(T&& item, bool new_one = false, handle_type handle = 0)
+        -> store_item_type {
+        return insert_impl(std::move(item), new_one, handle);
+    }
+
+private:
+    template<typename V>
+    auto insert_impl(V&& item, bool new_one, handle_type handle) -> store_item_type {
+        auto key = ItemTrait<T>::key(item);
         if (auto it = inner->map.find(key); it != inner->map.end()) {
-            it->second.item = item;
+            if (it->second.count == 0) inner->revive(it);
             // for store item
             it->second.increase();
 
             if (new_one) {
                 it->second.increase();
+                if (handle) it->second.subscribe(handle);
             }
 
-            changed.emplace_back(key);
+            if (detail::same_item(it->second.item, item)) {
+                ++inner->suppressed;
+            } else {
+                it->second.item = std::forward<V>(item);
+                inner->delay_callback(handle, key);
+            }
         } else {
-            inner->map.insert(std::pair { key, inner_item_type { item, 2 } });
-        }
-
-        if (! changed.empty()) {
-            inner->delay_callback(handle, std::move(changed));
+            Allocator alloc = get_allocator();
+            auto ins = inner->map.try_emplace(key, T(std::forward<V>(item)), new_one ? 2 : 1, alloc)
+                           .first;
+            if (new_one && handle) ins->second.subscribe(handle);
         }
 
         return { *this, key };
     }
 
+public:
+
     auto store_item(param_type<key_type> k) -> std::optional<store_item_type> {
         if (auto it = inner->map.find(k); it != inner->map.end()) {
+            if (it->second.count == 0) {
+                if (inner->expired(it->second)) {
+                    inner->evict(it);
+                    ++inner->stats.misses;
+                    return std::nullopt;
+                }
+                inner->revive(it);
+                ++inner->stats.hits;
+            }
             it->second.increase();
             return store_item_type { *this, k };
         }
+        ++inner->stats.misses;
         return std::nullopt;
     }
 
     void store_increase(param_type<key_type> k) {
         if (auto it = inner->map.find(k); it != inner->map.end()) {
+            if (it->second.count == 0) inner->revive(it);
             it->second.increase();
         }
     }
 
-    void store_remove(param_type<key_type> k) {
+    ///
+    /// @brief change some fields of a stored item in place
+    /// @param fn void(T&), changes no field outside touched, never the key
+    /// @param touched fields changed by fn, notified with the key
+    /// @param handle notify handle not to notify, 0 for none
+    /// @return false if the key is not stored
+    template<typename F>
+        requires std::invocable<F, T&>
+    bool store_patch(param_type<key_type> k, F&& fn, FieldMask touched, handle_type handle = 0) {
+        auto it = inner->map.find(k);
+        if (it == inner->map.end()) return false;
+        inner->resize_begin(it->second);
+        std::invoke(std::forward<F>(fn), it->second.item);
+        // the slot and every list index the item by its key
+        Q_ASSERT(ItemTrait<T>::key(it->second.item) == k);
+        inner->resize_end(it->second);
+        if (touched) inner->delay_callback(handle, k, touched);
+        return true;
+    }
+
+    ///
+    /// @brief copy the fields in mask from patch, fields equal to the stored ones are skipped
+    /// only data member pointers in ItemTrait::roles can be copied, mask must not hold the key
+    bool store_patch(param_type<key_type> k, const T& patch, FieldMask mask,
+                     handle_type handle = 0)
+        requires role_readable_item<T>
+    {
+        auto it = inner->map.find(k);
+        if (it == inner->map.end()) return false;
+        inner->resize_begin(it->second);
+        auto changed = detail::copy_fields(it->second.item, patch, mask);
+        Q_ASSERT(ItemTrait<T>::key(it->second.item) == k);
+        inner->resize_end(it->second);
+        if (changed) {
+            inner->delay_callback(handle, k, changed);
+        } else {
+            ++inner->suppressed;
+        }
+        return true;
+    }
+
+    ///
+    /// @param handle the notify handle that stops holding the key, 0 for none
+    void store_remove(param_type<key_type> k, handle_type handle = 0) {
         if (auto it = inner->map.find(k); it != inner->map.end()) {
+            if (handle) it->second.unsubscribe(handle);
             auto count = it->second.decrease();
-            if (count == 0) inner->map.erase(it);
+            if (count == 0) inner->release(it);
         }
     }
 
-    auto store_reg_notify(callback_type cb) -> handle_type {
+    ///
+    /// @brief move the filtered notify of key from one handle to another, 0 for none
+    /// counts don't change, e.g. when rows holding the key change list
+    void store_resubscribe(param_type<key_type> k, handle_type from, handle_type to) {
+        if (auto it = inner->map.find(k); it != inner->map.end()) {
+            if (from) it->second.unsubscribe(from);
+            if (to) it->second.subscribe(to);
+        }
+    }
+
+    ///
+    /// @brief retention of unreferenced entries, disabled by default
+    void set_retention(const StoreRetention& retention) {
+        inner->retention = retention;
+        inner->trim();
+    }
+    auto retention() const -> const StoreRetention& { return inner->retention; }
+    auto retention_stats() const -> const StoreRetentionStats& { return inner->stats; }
+
+    ///
+    /// @brief count of store_insert and store_patch that found the item unchanged
+    auto suppressed_updates() const -> usize { return inner->suppressed; }
+
+    ///
+    /// @param filtered only notify keys inserted with new_one and this handle,
+    /// until removed with it
+    auto store_reg_notify(callback_type cb, bool filtered = false) -> handle_type {
         auto handle = ++(inner->serial);
-        inner->callbacks.insert({ handle, cb });
+        inner->callbacks.insert({ handle, _Callback { std::move(cb), {}, filtered } });
+        return handle;
+    }
+    ///
+    /// @brief same as above, with the changed fields of each key
+    auto store_reg_notify(field_callback_type cb, bool filtered = false) -> handle_type {
+        auto handle = ++(inner->serial);
+        inner->callbacks.insert({ handle, _Callback { {}, std::move(cb), filtered } });
         return handle;
     }
     void store_unreg_notify(handle_type handle) { inner->callbacks.erase(handle); }
 
+    ///
+    /// @brief notify pending changes now instead of on the next event loop turn
+    void flush() { inner->flush(); }
+
     // extend
     auto query_extend(meta_model::param_type<key_type> key)
         -> TItemExtend* requires(! std::same_as<TItemExtend, void>) {
@@ -249,9 +662,20 @@ struct ShareStore {
             return nullptr;
         }
 
+    ///
+    /// @brief changes when a store_query pointer may dangle
+    auto store_generation() const -> std::uint64_t { return inner->generation; }
+
+    // retained entries included
     auto size() const -> std::size_t {
         return inner->map.size();
     }
 };
 
+namespace pmr
+{
+template<typename T, typename TItemExtend = void>
+using ShareStore = meta_model::ShareStore<T, std::pmr::polymorphic_allocator<T>, TItemExtend>;
+} // namespace pmr
+
 } // namespace meta_model
\ No newline at end of file
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <ranges>
+#include <vector>
+
+#include "meta_model/flat_map.hpp"
+#include "meta_model/item_trait.hpp"
+#include "meta_model/order_index.hpp"
+
+namespace meta_model
+{
+namespace detail
+{
+
+struct SyncOp {
+    enum class Type
+    {
+        Remove = 0,
+        Move,
+        Insert
+    };
+
+    Type type;
+    // remove/insert row, or move source row
+    usize row;
+    // move destination, same semantic as QAbstractItemModel::moveRows
+    usize dst;
+    usize count;
+    // insert: first index in new items
+    usize item;
+};
+
+///
+/// @brief edit script from old keys to new keys
+/// apply ops in order, then row i holds new item i,
+/// and rows in updates are the ones kept from old
+template<typename Allocator>
+struct SyncPlan {
+    template<typename U>
+    using rebind_alloc = detail::rebind_alloc<Allocator, U>;
+
+    SyncPlan(Allocator alloc = Allocator()): ops(alloc), updates(alloc), reset(false) {}
+
+    std::vector<SyncOp, rebind_alloc<SyncOp>> ops;
+    // [begin, end) of new items
+    std::vector<std::pair<usize, usize>, rebind_alloc<std::pair<usize, usize>>> updates;
+    // keys are not unique, can't diff
+    bool reset;
+};
+
+///
+/// @brief plan a minimal edit script with batched ranges
+/// rows not in new keys are removed in runs, the longest increasing subsequence
+/// of kept rows stays in place, other rows move once and new keys insert in runs
+template<typename K, typename Allocator, std::ranges::random_access_range Old,
+         std::ranges::random_access_range New>
+auto plan_sync(const Old& old_keys, const New& new_keys, Allocator alloc = Allocator())
+    -> SyncPlan<Allocator> {
+    using idx_map_type = HashMap<K, usize, Allocator>;
+
+    SyncPlan<Allocator> plan(alloc);
+    const usize         old_size = std::ranges::size(old_keys);
+    const usize         new_size = std::ranges::size(new_keys);
+
+    idx_map_type new_pos(alloc);
+    new_pos.reserve(new_size);
+    for (usize i = 0; i < new_size; i++) {
+        if (! new_pos.insert({ new_keys[i], i }).second) {
+            plan.reset = true;
+            return plan;
+        }
+    }
+
+    // remove, from back
+    std::vector<K, rebind_alloc<Allocator, K>>         kept(alloc);
+    std::vector<usize, rebind_alloc<Allocator, usize>> kept_pos(alloc);
+    {
+        idx_map_type seen(alloc);
+        seen.reserve(old_size);
+        for (usize i = 0; i < old_size; i++) {
+            if (! seen.insert({ old_keys[i], i }).second) {
+                plan.reset = true;
+                return plan;
+            }
+        }
+        for (usize i = old_size; i > 0;) {
+            --i;
+            if (auto it = new_pos.find(old_keys[i]); it != new_pos.end()) {
+                kept.push_back(old_keys[i]);
+                kept_pos.push_back(it->second);
+                continue;
+            }
+            auto last = i + 1;
+            while (i > 0 && ! new_pos.contains(old_keys[i - 1])) --i;
+            plan.ops.push_back({ SyncOp::Type::Remove, i, 0, last - i, 0 });
+        }
+        std::ranges::reverse(kept);
+        std::ranges::reverse(kept_pos);
+    }
+
+    // longest increasing subsequence of new positions, patience sorting
+    std::vector<usize, rebind_alloc<Allocator, usize>> tails(alloc);
+    std::vector<usize, rebind_alloc<Allocator, usize>> prev(kept_pos.size(), usize(-1), alloc);
+    for (usize r = 0; r < kept_pos.size(); r++) {
+        auto it = std::lower_bound(tails.begin(), tails.end(), kept_pos[r], [&](usize t, usize v) {
+            return kept_pos[t] < v;
+        });
+        if (it != tails.begin()) prev[r] = *(it - 1);
+        if (it == tails.end()) {
+            tails.push_back(r);
+        } else {
+            *it = r;
+        }
+    }
+
+    // 0: new, 1: move, 2: stay
+    std::vector<char, rebind_alloc<Allocator, char>> state(new_size, 0, alloc);
+    for (auto p : kept_pos) state[p] = 1;
+    if (! tails.empty()) {
+        for (auto r = tails.back(); r != usize(-1); r = prev[r]) state[kept_pos[r]] = 2;
+    }
+
+    // simulate on an index to get rows at each step
+    OrderIndex<K, Allocator> sim(alloc);
+    sim.insert(0, kept);
+    auto after_prev = [&](usize i) -> usize {
+        return i == 0 ? 0 : *sim.index_of(new_keys[i - 1]) + 1;
+    };
+    for (usize i = 0; i < new_size;) {
+        if (state[i] == 2) {
+            ++i;
+        } else if (state[i] == 0) {
+            auto j = i + 1;
+            while (j < new_size && state[j] == 0) ++j;
+            auto row = after_prev(i);
+            plan.ops.push_back({ SyncOp::Type::Insert, row, 0, j - i, i });
+            sim.insert(row, std::ranges::subrange(new_keys.begin() + i, new_keys.begin() + j));
+            i = j;
+        } else {
+            auto src = *sim.index_of(new_keys[i]);
+            auto j   = i + 1;
+            while (j < new_size && state[j] == 1 && sim.index_of(new_keys[j]) == src + (j - i)) {
+                ++j;
+            }
+            auto dst = after_prev(i);
+            if (dst != src) {
+                plan.ops.push_back({ SyncOp::Type::Move, src, dst, j - i, 0 });
+                sim.move(src, dst, j - i);
+            }
+            i = j;
+        }
+    }
+
+    for (usize i = 0; i < new_size; i++) {
+        if (state[i] == 0) continue;
+        if (! plan.updates.empty() && plan.updates.back().second == i) {
+            plan.updates.back().second = i + 1;
+        } else {
+            plan.updates.emplace_back(i, i + 1);
+        }
+    }
+    return plan;
+}
+
+} // namespace detail
+
+///
+/// @brief row keys of a model at a rows version, read only, shared across threads
+template<typename K, typename Allocator>
+struct SyncKeys {
+    using keys_type = std::vector<K, detail::rebind_alloc<Allocator, K>>;
+
+    std::uint64_t                    version;
+    std::shared_ptr<const keys_type> keys;
+};
+
+///
+/// @brief edit script from SyncKeys to items, with the items to apply
+template<typename T, typename Allocator>
+struct PlannedSync {
+    PlannedSync(Allocator alloc = Allocator()): version(0), plan(alloc), items(alloc) {}
+
+    std::uint64_t                                      version;
+    detail::SyncPlan<Allocator>                        plan;
+    std::vector<T, detail::rebind_alloc<Allocator, T>> items;
+};
+
+} // namespace meta_model
@@ -0,0 +1,38 @@
+#include "meta_model/page_loader.hpp"
+
+namespace meta_model::detail
+{
+PageLoaderBase::PageLoaderBase(QObject* parent)
+    : QObject(parent), m_visible_first(-1), m_visible_last(-1), m_loading(false), m_first(0) {}
+PageLoaderBase::~PageLoaderBase() {}
+
+auto PageLoaderBase::loading() const -> bool { return m_loading; }
+void PageLoaderBase::setLoading(bool v) {
+    if (m_loading != v) {
+        m_loading = v;
+        loadingChanged(v);
+    }
+}
+
+auto PageLoaderBase::firstOffset() const -> qint64 { return m_first; }
+auto PageLoaderBase::hasPrevious() const -> bool { return m_first > 0; }
+void PageLoaderBase::setFirstOffset(qint64 v) {
+    if (m_first != v) {
+        m_first = v;
+        windowChanged();
+    }
+}
+
+void PageLoaderBase::setVisibleRow(qint32 row) {
+    // only the last shown row is known, the window follows it
+    setVisibleRows(row, row);
+}
+void PageLoaderBase::setVisibleRows(qint32 first, qint32 last) {
+    m_visible_first = first;
+    m_visible_last  = std::max(first, last);
+    fill();
+}
+void PageLoaderBase::fetchPrevious() { fill_previous(); }
+} // namespace meta_model::detail
+
+#include "meta_model/moc_page_loader.cpp"
@@ -1,5 +1,8 @@
 #include "meta_model/qmeta_list_model.hpp"
 
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
 #include <QMetaProperty>
 
 namespace meta_model
@@ -7,8 +10,73 @@ namespace meta_model
 
 namespace detail
 {
+template<typename F>
+void QMetaListModelBase::remapPending(std::initializer_list<int> cuts, F&& map) {
+    if (m_pending.empty()) return;
+    std::vector<PendingChange> out;
+    out.reserve(m_pending.size());
+    for (auto& p : m_pending) {
+        // split at cuts, each piece maps linearly
+        auto first = p.first;
+        while (first <= p.last) {
+            auto last = p.last;
+            for (auto c : cuts) {
+                if (c > first && c - 1 < last) last = c - 1;
+            }
+            if (auto f = map(first)) {
+                out.push_back({ *f, *f + (last - first), p.roles });
+            }
+            first = last + 1;
+        }
+    }
+    m_pending = std::move(out);
+}
+
 QMetaListModelBase::QMetaListModelBase(QObject* parent)
-    : QMetaModelBase<QAbstractListModel>(parent), m_has_more(false) {}
+    : QMetaModelBase<QAbstractListModel>(parent),
+      m_has_more(false),
+      m_update_depth(0),
+      m_rows_version(0) {
+    // keep deferred rows valid across structure changes
+    connect(this,
+            &QAbstractItemModel::rowsInserted,
+            this,
+            [this](const QModelIndex&, int first, int last) {
+                auto n = last - first + 1;
+                remapPending({ first }, [first, n](int row) -> std::optional<int> {
+                    return row < first ? row : row + n;
+                });
+            });
+    connect(this,
+            &QAbstractItemModel::rowsRemoved,
+            this,
+            [this](const QModelIndex&, int first, int last) {
+                auto n = last - first + 1;
+                remapPending({ first, last + 1 }, [first, last, n](int row) -> std::optional<int> {
+                    if (row < first) return row;
+                    if (row > last) return row - n;
+                    return std::nullopt;
+                });
+            });
+    connect(this,
+            &QAbstractItemModel::rowsMoved,
+            this,
+            [this](const QModelIndex&, int start, int end, const QModelIndex&, int dst) {
+                auto n = end - start + 1;
+                remapPending({ start, end + 1, dst },
+                             [start, end, dst, n](int row) -> std::optional<int> {
+                                 if (row >= start && row <= end) {
+                                     return dst < start ? row - start + dst : row - start + dst - n;
+                                 }
+                                 if (dst < start && row >= dst && row < start) return row + n;
+                                 if (dst > end && row > end && row < dst) return row - n;
+                                 return row;
+                             });
+            });
+    connect(this, &QAbstractItemModel::modelAboutToBeReset, this, [this] {
+        m_pending.clear();
+    });
+}
 QMetaListModelBase::~QMetaListModelBase() {}
 auto QMetaListModelBase::hasMore() const -> bool { return m_has_more; }
 void QMetaListModelBase::setHasMore(bool v) {
@@ -23,17 +91,70 @@ void QMetaListModelBase::fetchMore(const QModelIndex&) {
     reqFetchMore(rowCount());
 }
 
+void QMetaListModelBase::beginUpdate() { ++m_update_depth; }
+void QMetaListModelBase::endUpdate() {
+    Q_ASSERT(m_update_depth > 0);
+    if (--m_update_depth > 0) return;
+
+    auto pending = std::move(m_pending);
+    m_pending.clear();
+    std::sort(pending.begin(), pending.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+    for (std::size_t i = 0; i < pending.size();) {
+        auto cur = std::move(pending[i]);
+        auto j   = i + 1;
+        for (; j < pending.size() && pending[j].first <= cur.last + 1; j++) {
+            auto& next = pending[j];
+            cur.last   = std::max(cur.last, next.last);
+            if (cur.roles.empty() || next.roles.empty()) {
+                cur.roles.clear();
+            } else {
+                cur.roles.insert(cur.roles.end(), next.roles.begin(), next.roles.end());
+            }
+        }
+        std::sort(cur.roles.begin(), cur.roles.end());
+        cur.roles.erase(std::unique(cur.roles.begin(), cur.roles.end()), cur.roles.end());
+        dataChanged(index(cur.first), index(cur.last), cur.roles);
+        i = j;
+    }
+}
+auto QMetaListModelBase::inUpdate() const -> bool { return m_update_depth > 0; }
+auto QMetaListModelBase::rowsVersion() const -> std::uint64_t { return m_rows_version; }
+
+void QMetaListModelBase::notifyDataChanged(int first, int last, const QList<int>& roles) {
+    if (first > last) return;
+    if (m_update_depth > 0) {
+        m_pending.push_back({ first, last, roles });
+    } else {
+        dataChanged(index(first), index(last), roles);
+    }
+}
+
+
 } // namespace detail
 
-void detail::update_role_names(QHash<int, QByteArray>& role_names, const QMetaObject& meta) {
-    role_names.clear();
+auto detail::role_table(const QMetaObject& meta) -> std::shared_ptr<const RoleTable> {
+    // meta objects are copied around by value, d.data identifies the class
+    static std::mutex mutex;
+    static std::unordered_map<const void*, std::shared_ptr<const RoleTable>> tables;
 
-    auto roleIndex = Qt::UserRole + 1;
-    for (auto i = 0; i < meta.propertyCount(); i++) {
-        auto prop = meta.property(i);
-        role_names.insert(roleIndex, prop.name());
-        ++roleIndex;
+    std::lock_guard lock { mutex };
+    auto&           table = tables[meta.d.data];
+    if (! table) {
+        auto t = std::make_shared<RoleTable>();
+        t->props.reserve(meta.propertyCount());
+        auto roleIndex = RoleTable::first_role;
+        for (auto i = 0; i < meta.propertyCount(); i++) {
+            auto prop = meta.property(i);
+            t->role_names.insert(roleIndex, prop.name());
+            t->name_roles.insert(prop.name(), roleIndex);
+            t->props.push_back(prop);
+            ++roleIndex;
+        }
+        table = std::move(t);
     }
+    return table;
 }
 
 auto readOnGadget(const QVariant& obj, const char* name) -> QVariant {
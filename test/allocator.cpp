@@ -0,0 +1,121 @@
+#include <memory_resource>
+#include <gtest/gtest.h>
+
+#include "meta_model/arena.hpp"
+#include "meta_model/qgadget_list_model.hpp"
+
+namespace
+{
+class CountingResource : public std::pmr::memory_resource {
+public:
+    std::size_t allocs { 0 };
+    std::size_t outstanding { 0 };
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t align) override {
+        ++allocs;
+        outstanding += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, align);
+    }
+    void do_deallocate(void* p, std::size_t bytes, std::size_t align) override {
+        outstanding -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override {
+        return this == &o;
+    }
+};
+} // namespace
+
+struct PmrGadget {
+    Q_GADGET
+
+    Q_PROPERTY(int uid MEMBER uid)
+public:
+    int uid;
+    int age { 18 };
+};
+
+template<>
+struct meta_model::ItemTrait<PmrGadget> {
+    using key_type   = int;
+    using store_type = meta_model::pmr::ShareStore<PmrGadget>;
+    static auto key(meta_model::param_type<PmrGadget> m) { return m.uid; }
+};
+
+template<meta_model::QMetaListStore Store>
+void exercise(std::pmr::memory_resource* res) {
+    using model_type = meta_model::pmr::QGadgetListModel<PmrGadget, Store>;
+    model_type m(nullptr, typename model_type::allocator_type { res });
+    if constexpr (Store == meta_model::QMetaListStore::Share) {
+        m.set_store(&m, meta_model::pmr::ShareStore<PmrGadget> { res });
+    }
+
+    std::vector<PmrGadget> items;
+    for (int i = 0; i < 300; i++) items.push_back({ i });
+    m.insert(0, items);
+    m.move(0, 10, 5);
+    m.remove_if([](const PmrGadget& g) {
+        return g.uid % 7 == 0;
+    });
+    std::ranges::reverse(items);
+    m.sync(items);
+    items.push_back({ 1000 });
+    m.extend(items);
+    EXPECT_EQ(m.rowCount(), 301);
+}
+
+template<meta_model::QMetaListStore Store>
+void check_resource() {
+    CountingResource res;
+    exercise<Store>(&res);
+    EXPECT_GT(res.allocs, 0u);
+    EXPECT_EQ(res.outstanding, 0u);
+}
+
+TEST(Allocator, Vector) { check_resource<meta_model::QMetaListStore::Vector>(); }
+TEST(Allocator, VectorWithMap) { check_resource<meta_model::QMetaListStore::VectorWithMap>(); }
+TEST(Allocator, Map) { check_resource<meta_model::QMetaListStore::Map>(); }
+TEST(Allocator, Chunked) { check_resource<meta_model::QMetaListStore::Chunked>(); }
+TEST(Allocator, Share) { check_resource<meta_model::QMetaListStore::Share>(); }
+
+TEST(Allocator, ShareSubscribers) {
+    CountingResource                       res;
+    meta_model::pmr::ShareStore<PmrGadget> store { &res };
+    auto                                   item = store.store_insert(PmrGadget { 1 });
+
+    auto allocs = res.allocs;
+    store.store_resubscribe(1, 0, 7);
+    EXPECT_EQ(res.allocs, allocs + 1);
+}
+
+TEST(Allocator, SyncKeys) {
+    using model_type =
+        meta_model::pmr::QGadgetListModel<PmrGadget, meta_model::QMetaListStore::VectorWithMap>;
+    CountingResource res;
+    model_type       m(nullptr, model_type::allocator_type { &res });
+    m.insert(0, std::vector<PmrGadget> { { 1 }, { 2 }, { 3 } });
+
+    // the planning thread frees the keys, off the model resource
+    auto allocs = res.allocs;
+    auto keys   = m.sync_keys();
+    EXPECT_EQ(res.allocs, allocs);
+    ASSERT_EQ(keys.keys->size(), 3u);
+    EXPECT_EQ(keys.keys->at(2), 3);
+}
+
+TEST(Allocator, Arena) {
+    CountingResource upstream;
+    {
+        meta_model::Arena arena(4096, &upstream);
+        exercise<meta_model::QMetaListStore::Map>(arena.resource());
+        exercise<meta_model::QMetaListStore::Share>(arena.resource());
+        EXPECT_GT(upstream.outstanding, 0u);
+
+        arena.release();
+        EXPECT_EQ(upstream.outstanding, 0u);
+    }
+    EXPECT_EQ(upstream.outstanding, 0u);
+}
+
+#include "allocator.moc"
@@ -0,0 +1,73 @@
+#include <numeric>
+#include <random>
+#include <gtest/gtest.h>
+
+#include "meta_model/chunked_list.hpp"
+
+TEST(ChunkedList, Random) {
+    meta_model::detail::ChunkedList<int, std::allocator<int>, 4> list;
+    std::vector<int>                                             ref;
+
+    std::mt19937 gen(11);
+    int          next = 0;
+    auto         pick = [&gen](std::size_t n) {
+        return std::uniform_int_distribution<std::size_t>(0, n)(gen);
+    };
+    for (int round = 0; round < 3000; round++) {
+        switch (gen() % 3) {
+        case 0: {
+            auto             pos = pick(ref.size());
+            std::vector<int> vals;
+            for (auto n = pick(12); n > 0; n--) vals.push_back(next++);
+            list.insert(pos, vals);
+            ref.insert(ref.begin() + pos, vals.begin(), vals.end());
+            break;
+        }
+        case 1: {
+            if (ref.empty()) break;
+            auto pos  = pick(ref.size() - 1);
+            auto last = std::min(ref.size(), pos + pick(10));
+            list.erase(pos, last);
+            ref.erase(ref.begin() + pos, ref.begin() + last);
+            break;
+        }
+        case 2: {
+            if (ref.empty()) break;
+            auto src   = pick(ref.size() - 1);
+            auto count = 1 + pick(ref.size() - src - 1);
+            auto dst   = pick(ref.size());
+            if (dst >= src && dst <= src + count) break;
+            list.move(src, dst, count);
+            auto it = ref.begin();
+            if (src > dst) {
+                std::rotate(it + dst, it + src, it + src + count);
+            } else {
+                std::rotate(it + src, it + src + count, it + dst);
+            }
+            break;
+        }
+        }
+        ASSERT_EQ(list.size(), ref.size());
+        ASSERT_TRUE(std::equal(list.begin(), list.end(), ref.begin(), ref.end()));
+    }
+    for (std::size_t i = 0; i < ref.size(); i++) {
+        EXPECT_EQ(list.at(i), ref[i]);
+    }
+}
+
+TEST(ChunkedList, ScatteredErase) {
+    meta_model::detail::ChunkedList<int, std::allocator<int>, 8> list;
+    std::vector<int>                                             ref(4000);
+    std::iota(ref.begin(), ref.end(), 0);
+    list.insert(0, ref);
+
+    // erase every other row, from the back so positions stay valid
+    while (ref.size() > 10) {
+        for (auto i = ref.size() - 1; i > 0; i -= std::min<std::size_t>(i, 2)) {
+            list.erase(i, i + 1);
+            ref.erase(ref.begin() + i);
+        }
+        ASSERT_TRUE(std::equal(list.begin(), list.end(), ref.begin(), ref.end()));
+        ASSERT_LE(list.chunk_count(), 2 * ref.size() / 8 + 1);
+    }
+}
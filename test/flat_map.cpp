@@ -0,0 +1,89 @@
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <gtest/gtest.h>
+
+#include "meta_model/flat_map.hpp"
+
+TEST(FlatMap, Random) {
+    meta_model::detail::FlatMap<int, std::string> map;
+    std::unordered_map<int, std::string>          expect;
+
+    std::mt19937 gen(11);
+    for (int round = 0; round < 20000; round++) {
+        int key = gen() % 512;
+        switch (gen() % 4) {
+        case 0:
+        case 1: {
+            auto val = std::to_string(round);
+            EXPECT_EQ(map.insert_or_assign(key, val).second,
+                      expect.insert_or_assign(key, val).second);
+            break;
+        }
+        case 2: {
+            EXPECT_EQ(map.erase(key), expect.erase(key));
+            break;
+        }
+        case 3: {
+            auto it = map.find(key);
+            auto ex = expect.find(key);
+            ASSERT_EQ(it == map.end(), ex == expect.end());
+            if (ex != expect.end()) {
+                EXPECT_EQ(it->second, ex->second);
+            }
+            break;
+        }
+        }
+        ASSERT_EQ(map.size(), expect.size());
+    }
+
+    std::size_t n = 0;
+    for (auto& [k, v] : map) {
+        EXPECT_EQ(expect.at(k), v);
+        ++n;
+    }
+    EXPECT_EQ(n, expect.size());
+
+    // erase while iterating
+    for (auto it = map.begin(); it != map.end();) {
+        it = it->first % 2 ? map.erase(it) : std::next(it);
+    }
+    std::erase_if(expect, [](auto& el) {
+        return el.first % 2;
+    });
+    EXPECT_EQ(map.size(), expect.size());
+    for (auto& [k, v] : expect) EXPECT_TRUE(map.contains(k));
+
+    auto copy = map;
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(copy.size(), expect.size());
+}
+
+TEST(FlatMap, Rehash) {
+    meta_model::detail::FlatMap<int, int> map;
+
+    // every key is found after each growth
+    std::size_t capacity = map.capacity();
+    int         grown    = 0;
+    for (int i = 0; i < 10000; i++) {
+        map.try_emplace(i, i);
+        if (map.capacity() == capacity) continue;
+        capacity = map.capacity();
+        ++grown;
+        for (int k = 0; k <= i; k++) {
+            auto it = map.find(k);
+            ASSERT_TRUE(it != map.end()) << k;
+            EXPECT_EQ(it->second, k);
+        }
+    }
+    EXPECT_GT(grown, 4);
+
+    // tombstones left by erase don't hide keys after a rehash
+    for (int i = 0; i < 10000; i += 2) map.erase(i);
+    for (int i = 10000; i < 20000; i++) map.try_emplace(i, i);
+    for (int i = 0; i < 20000; i++) {
+        EXPECT_EQ(map.contains(i), i >= 10000 || i % 2) << i;
+    }
+    EXPECT_EQ(map.size(), 15000u);
+}
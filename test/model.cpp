@@ -0,0 +1,489 @@
+#include <random>
+#include <thread>
+#include <gtest/gtest.h>
+
+#include "meta_model/qgadget_list_model.hpp"
+
+struct Gadget {
+    Q_GADGET
+
+    Q_PROPERTY(int uid MEMBER uid)
+    Q_PROPERTY(QString name READ getName)
+public:
+    int     uid;
+    QString name;
+
+    auto getName() const -> QString { return name; }
+};
+
+template<>
+struct meta_model::ItemTrait<Gadget> {
+    using key_type              = int;
+    static constexpr auto roles = std::tuple { &Gadget::uid, &Gadget::getName };
+    static auto key(meta_model::param_type<Gadget> m) { return m.uid; }
+};
+
+struct GadgetModel : meta_model::QGadgetListModel<Gadget, meta_model::QMetaListStore::Vector> {
+    Q_OBJECT
+public:
+    using base_type = meta_model::QGadgetListModel<Gadget, meta_model::QMetaListStore::Vector>;
+    GadgetModel(QObject* p = nullptr): base_type(p) {}
+};
+
+struct Counted {
+    Q_GADGET
+
+    Q_PROPERTY(int uid MEMBER uid)
+public:
+    Counted(int uid = 0): uid(uid) {}
+    Counted(const Counted& o): uid(o.uid) { ++copies; }
+    Counted(Counted&& o) noexcept: uid(o.uid) { ++moves; }
+    Counted& operator=(const Counted& o) {
+        uid = o.uid;
+        ++copies;
+        return *this;
+    }
+    Counted& operator=(Counted&& o) noexcept {
+        uid = o.uid;
+        ++moves;
+        return *this;
+    }
+
+    int               uid;
+    static inline int copies { 0 };
+    static inline int moves { 0 };
+};
+
+template<>
+struct meta_model::ItemTrait<Counted> {
+    using key_type   = int;
+    using store_type = meta_model::ShareStore<Counted>;
+    static auto key(const Counted& m) { return m.uid; }
+};
+
+TEST(Model, TypedRole) {
+    GadgetModel m;
+    m.insert(0, std::array { Gadget { 1, "a" }, Gadget { 2, "b" } });
+
+    EXPECT_EQ(m.data(m.index(1), Qt::UserRole + 1).value<int>(), 2);
+    EXPECT_EQ(m.data(m.index(0), Qt::UserRole + 2).value<QString>(), "a");
+    EXPECT_FALSE(m.data(m.index(0), Qt::UserRole + 3).isValid());
+}
+
+TEST(Model, MapSync) {
+    meta_model::QGadgetListModel<Gadget, meta_model::QMetaListStore::Map> m;
+    m.insert(0, std::array { Gadget { 1 }, Gadget { 2 }, Gadget { 3 }, Gadget { 4 } });
+    EXPECT_EQ(m.query_idx(3), 2u);
+
+    m.sync(std::array { Gadget { 4 }, Gadget { 5 }, Gadget { 1, "a" }, Gadget { 3 } });
+    ASSERT_EQ(m.rowCount(), 4);
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(m.query_idx(m.key_at(i)), (std::size_t)i);
+    }
+    EXPECT_EQ(m.at(0).uid, 4);
+    EXPECT_EQ(m.at(1).uid, 5);
+    EXPECT_EQ(m.at(2).name, "a");
+    EXPECT_FALSE(m.query_idx(2));
+}
+
+TEST(Model, VectorWithMapIndex) {
+    meta_model::QGadgetListModel<Gadget, meta_model::QMetaListStore::VectorWithMap> m;
+    m.insert(0, std::array { Gadget { 3 }, Gadget { 4 } });
+    m.insert(0, std::array { Gadget { 1 }, Gadget { 2 } });
+    m.insert(1, std::array { Gadget { 5 }, Gadget { 4, "b" } });
+    m.remove(0);
+
+    ASSERT_EQ(m.rowCount(), 4);
+    EXPECT_EQ(m.at(0).uid, 5);
+    EXPECT_EQ(m.at(3).name, "b");
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(m.query_idx(m.key_at(i)), (std::size_t)i);
+    }
+    EXPECT_FALSE(m.query_idx(1));
+}
+
+TEST(Model, ChunkedSync) {
+    meta_model::QGadgetListModel<Gadget, meta_model::QMetaListStore::Chunked> m;
+    m.insert(0, std::array { Gadget { 1 }, Gadget { 2 }, Gadget { 3 } });
+    m.move(2, 0, 1);
+    EXPECT_EQ(m.at(0).uid, 3);
+
+    m.sync(std::array { Gadget { 2, "b" }, Gadget { 3 } });
+    ASSERT_EQ(m.rowCount(), 2);
+    EXPECT_EQ(m.at(0).name, "b");
+    EXPECT_EQ(m.at(1).uid, 3);
+
+    EXPECT_EQ(m.extend(std::array { Gadget { 4 }, Gadget { 3, "c" } }), 1u);
+    ASSERT_EQ(m.rowCount(), 3);
+    EXPECT_EQ(m.at(1).name, "c");
+    EXPECT_EQ(m.at(2).uid, 4);
+}
+
+TEST(Model, RemoveIf) {
+    meta_model::QGadgetListModel<Gadget, meta_model::QMetaListStore::VectorWithMap> m;
+    std::vector<Gadget> items;
+    for (int i = 0; i < 10; i++) items.push_back(Gadget { i });
+    m.insert(0, items);
+
+    m.remove_if([](const Gadget& g) {
+        return g.uid < 2 || (g.uid > 3 && g.uid < 7) || g.uid == 9;
+    });
+    ASSERT_EQ(m.rowCount(), 4);
+    EXPECT_EQ(m.at(0).uid, 2);
+    EXPECT_EQ(m.at(2).uid, 7);
+    EXPECT_EQ(m.query_idx(8), 3u);
+}
+
+TEST(Model, SyncPlan) {
+    using meta_model::detail::plan_sync;
+    auto alloc = std::allocator<int> {};
+
+    auto plan = plan_sync<int>(std::vector { 1, 2, 3, 4, 5 }, std::vector { 2, 3, 4, 5, 1 }, alloc);
+    EXPECT_EQ(plan.ops.size(), 1u);
+
+    plan = plan_sync<int>(std::vector { 1, 2, 3, 9 }, std::vector { 0, 1, 2, 3 }, alloc);
+    ASSERT_EQ(plan.ops.size(), 2u);
+    EXPECT_EQ(plan.ops[0].type, meta_model::detail::SyncOp::Type::Remove);
+    EXPECT_EQ(plan.ops[1].type, meta_model::detail::SyncOp::Type::Insert);
+    ASSERT_EQ(plan.updates.size(), 1u);
+    EXPECT_EQ(plan.updates[0].first, 1u);
+    EXPECT_EQ(plan.updates[0].second, 4u);
+
+    plan = plan_sync<int>(std::vector { 1, 1 }, std::vector { 1 }, alloc);
+    EXPECT_TRUE(plan.reset);
+}
+
+TEST(Model, SyncRandom) {
+    std::mt19937 gen(3);
+    for (int round = 0; round < 200; round++) {
+        meta_model::QGadgetListModel<Gadget, meta_model::QMetaListStore::VectorWithMap> m;
+        std::vector<Gadget> items;
+        for (int i = 0; i < 30; i++) {
+            if (gen() % 2) items.push_back(Gadget { i });
+        }
+        std::shuffle(items.begin(), items.end(), gen);
+        m.insert(0, items);
+
+        items.clear();
+        for (int i = 0; i < 30; i++) {
+            if (gen() % 2) items.push_back(Gadget { i, "new" });
+        }
+        std::shuffle(items.begin(), items.end(), gen);
+        m.sync(items);
+
+        ASSERT_EQ(m.size(), items.size());
+        for (std::size_t i = 0; i < items.size(); i++) {
+            EXPECT_EQ(m.at(i).uid, items[i].uid);
+            EXPECT_EQ(m.at(i).name, "new");
+        }
+    }
+}
+
+TEST(Model, Extend) {
+    meta_model::QGadgetListModel<Gadget, meta_model::QMetaListStore::VectorWithMap> m;
+    m.insert(0, std::array { Gadget { 1 }, Gadget { 2 } });
+
+    auto n = m.extend(std::array { Gadget { 5 }, Gadget { 2, "b" }, Gadget { 3 }, Gadget { 4 } });
+    EXPECT_EQ(n, 3u);
+    ASSERT_EQ(m.rowCount(), 5);
+    EXPECT_EQ(m.at(1).name, "b");
+    EXPECT_EQ(m.at(2).uid, 5);
+    EXPECT_EQ(m.at(4).uid, 4);
+    EXPECT_EQ(m.query_idx(3), 3u);
+}
+
+TEST(Model, UpdateTransaction) {
+    meta_model::QGadgetListModel<Gadget, meta_model::QMetaListStore::Vector> m;
+    m.insert(0, std::array { Gadget { 1 }, Gadget { 2 }, Gadget { 3 }, Gadget { 4 } });
+
+    std::vector<std::tuple<int, int, QList<int>>> changed;
+    QObject::connect(&m,
+                     &QAbstractItemModel::dataChanged,
+                     &m,
+                     [&changed](const QModelIndex& a, const QModelIndex& b, const QList<int>& roles) {
+                         changed.emplace_back(a.row(), b.row(), roles);
+                     });
+    {
+        meta_model::detail::QMetaListModelBase::UpdateGuard guard { m };
+        m.notifyDataChanged(0, 0, { 1 });
+        m.notifyDataChanged(1, 1, { 2 });
+        m.notifyDataChanged(3, 3);
+        m.insert(0, Gadget { 0 });
+        m.remove(4);
+        EXPECT_TRUE(changed.empty());
+    }
+    ASSERT_EQ(changed.size(), 1u);
+    EXPECT_EQ(changed[0], std::make_tuple(1, 2, QList<int> { 1, 2 }));
+}
+
+TEST(Model, ChangedRoles) {
+    meta_model::QGadgetListModel<Gadget, meta_model::QMetaListStore::VectorWithMap> m;
+    m.insert(0, std::array { Gadget { 1 }, Gadget { 2 }, Gadget { 3 } });
+
+    std::vector<std::tuple<int, int, QList<int>>> changed;
+    QObject::connect(&m,
+                     &QAbstractItemModel::dataChanged,
+                     &m,
+                     [&changed](const QModelIndex& a, const QModelIndex& b, const QList<int>& roles) {
+                         changed.emplace_back(a.row(), b.row(), roles);
+                     });
+
+    m.replace(0, Gadget { 1 });
+    EXPECT_TRUE(changed.empty());
+
+    m.sync(std::array { Gadget { 1 }, Gadget { 2, "b" }, Gadget { 3, "c" } });
+    ASSERT_EQ(changed.size(), 1u);
+    EXPECT_EQ(changed[0], std::make_tuple(1, 2, QList<int> { Qt::UserRole + 2 }));
+}
+
+template<meta_model::QMetaListStore Store>
+void replace_keys() {
+    auto make = [](std::initializer_list<int> uids) {
+        std::vector<Counted> out;
+        for (auto uid : uids) out.emplace_back(uid);
+        return out;
+    };
+
+    meta_model::ShareStore<Counted>              store;
+    meta_model::QGadgetListModel<Counted, Store> m;
+    if constexpr (Store == meta_model::QMetaListStore::Share) m.set_store(&m, store);
+    m.insert(0, make({ 1, 2, 3 }));
+
+    int resets = 0;
+    QObject::connect(&m, &QAbstractItemModel::modelReset, &m, [&resets] {
+        ++resets;
+    });
+
+    // a new key in the row
+    m.replace(1, Counted { 4 });
+    EXPECT_EQ(m.at(1).uid, 4);
+    EXPECT_EQ(m.query_idx(4), 1);
+    EXPECT_FALSE(m.query_idx(2));
+
+    // a key of another row, that row takes it
+    m.replace(0, Counted { 3 });
+    ASSERT_EQ(m.rowCount(), 2);
+    EXPECT_EQ(m.at(0).uid, 4);
+    EXPECT_EQ(m.query_idx(3), 1);
+    EXPECT_FALSE(m.query_idx(1));
+
+    // keys change position
+    m.replaceResetModel(make({ 3, 4, 5 }));
+    EXPECT_EQ(resets, 1);
+    ASSERT_EQ(m.rowCount(), 3);
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(m.at(i).uid, i + 3);
+        EXPECT_EQ(m.query_idx(i + 3), i);
+    }
+
+    // new keys stay in place
+    m.replaceResetModel(make({ 6, 4, 5 }));
+    EXPECT_EQ(resets, 1);
+    EXPECT_EQ(m.query_idx(6), 0);
+    EXPECT_FALSE(m.query_idx(3));
+    if constexpr (Store == meta_model::QMetaListStore::Share) {
+        EXPECT_EQ(store.size(), 3u);
+    }
+}
+
+TEST(Model, ReplaceKeys) {
+    replace_keys<meta_model::QMetaListStore::VectorWithMap>();
+    replace_keys<meta_model::QMetaListStore::Map>();
+    replace_keys<meta_model::QMetaListStore::Share>();
+}
+
+template<meta_model::QMetaListStore Store>
+void count_copies() {
+    auto make = [](std::initializer_list<int> uids) {
+        std::vector<Counted> out;
+        for (auto uid : uids) out.emplace_back(uid);
+        return out;
+    };
+
+    meta_model::QGadgetListModel<Counted, Store> m;
+    if constexpr (Store == meta_model::QMetaListStore::Share) {
+        m.set_store(&m, meta_model::ShareStore<Counted> {});
+    }
+    Counted::copies = 0;
+
+    m.insert(0, make({ 1, 2, 3 }));
+    m.insert(0, Counted { 0 });
+    m.resetModel(make({ 4, 5, 6 }));
+    m.sync(make({ 7, 6, 4, 8 }));
+    m.extend(make({ 9, 4 }));
+    EXPECT_EQ(m.rowCount(), 5);
+    EXPECT_EQ(Counted::copies, 0);
+
+    // lvalues are still copied
+    auto items = make({ 10 });
+    m.extend(items);
+    EXPECT_EQ(Counted::copies, 1);
+    EXPECT_EQ(items[0].uid, 10);
+}
+
+TEST(Model, AppendGrowth) {
+    meta_model::QGadgetListModel<Counted, meta_model::QMetaListStore::Vector> m;
+    Counted::moves = 0;
+    for (int i = 0; i < 1000; i++) m.insert(m.rowCount(), Counted { i });
+    EXPECT_EQ(m.rowCount(), 1000);
+    // one move in plus amortized reallocation, not the whole list per append
+    EXPECT_LT(Counted::moves, 4000);
+}
+
+TEST(Model, MoveInsert) {
+    count_copies<meta_model::QMetaListStore::Vector>();
+    count_copies<meta_model::QMetaListStore::VectorWithMap>();
+    count_copies<meta_model::QMetaListStore::Map>();
+    count_copies<meta_model::QMetaListStore::Chunked>();
+    count_copies<meta_model::QMetaListStore::Share>();
+}
+
+template<meta_model::QMetaListStore Store>
+void swap_snapshot() {
+    using model_type = meta_model::QGadgetListModel<Gadget, Store>;
+    model_type m;
+    m.insert(0, std::array { Gadget { -1, "old" } });
+
+    int resets = 0;
+    QObject::connect(&m, &QAbstractItemModel::modelReset, &m, [&resets] {
+        ++resets;
+    });
+
+    std::optional<typename model_type::snapshot_type> snapshot;
+    std::thread                                       worker([&snapshot] {
+        std::vector<Gadget> items;
+        for (int i = 0; i < 10000; i++) items.push_back(Gadget { i, {} });
+        snapshot.emplace(std::move(items));
+    });
+    worker.join();
+
+    m.swap_snapshot(*snapshot);
+    EXPECT_EQ(resets, 1);
+    EXPECT_EQ(m.rowCount(), 10000);
+    EXPECT_EQ(m.at(9999).uid, 9999);
+    if constexpr (Store != meta_model::QMetaListStore::Vector &&
+                  Store != meta_model::QMetaListStore::Chunked) {
+        EXPECT_EQ(m.query_idx(1234), 1234);
+    }
+    // old rows went to the snapshot
+    ASSERT_EQ(snapshot->size(), 1);
+    EXPECT_EQ(snapshot->at(0).uid, -1);
+
+    // through sync, no reset
+    m.sync_snapshot(typename model_type::snapshot_type { std::array { Gadget { 3, "x" },
+                                                                      Gadget { 1, {} } } });
+    EXPECT_EQ(resets, 1);
+    ASSERT_EQ(m.rowCount(), 2);
+    EXPECT_EQ(m.at(0).name, "x");
+    EXPECT_EQ(m.at(1).uid, 1);
+}
+
+TEST(Model, Snapshot) {
+    swap_snapshot<meta_model::QMetaListStore::Vector>();
+    swap_snapshot<meta_model::QMetaListStore::VectorWithMap>();
+    swap_snapshot<meta_model::QMetaListStore::Map>();
+    swap_snapshot<meta_model::QMetaListStore::Chunked>();
+}
+
+TEST(Model, PlannedSync) {
+    using model_type =
+        meta_model::QGadgetListModel<Gadget, meta_model::QMetaListStore::VectorWithMap>;
+    model_type          m;
+    std::vector<Gadget> init;
+    for (int i = 0; i < 100; i++) init.push_back(Gadget { i, {} });
+    m.resetModel(init);
+
+    int resets = 0;
+    QObject::connect(&m, &QAbstractItemModel::modelReset, &m, [&resets] {
+        ++resets;
+    });
+
+    // even rows, reversed
+    auto plan_on_worker = [](auto keys) {
+        std::optional<meta_model::PlannedSync<Gadget, model_type::allocator_type>> planned;
+        std::thread worker([&planned, keys] {
+            std::vector<Gadget> items;
+            for (int i = 98; i >= 0; i -= 2) items.push_back(Gadget { i, "n" });
+            planned = model_type::plan_sync(keys, std::move(items));
+        });
+        worker.join();
+        return std::move(*planned);
+    };
+
+    auto planned = plan_on_worker(m.sync_keys());
+    EXPECT_TRUE(m.apply(std::move(planned)));
+    EXPECT_EQ(resets, 0);
+    ASSERT_EQ(m.rowCount(), 50);
+    EXPECT_EQ(m.at(0).uid, 98);
+    EXPECT_EQ(m.at(49).uid, 0);
+    EXPECT_EQ(m.at(49).name, "n");
+    EXPECT_EQ(m.query_idx(50), 24);
+
+    // rows changed after the keys were taken
+    m.resetModel(init);
+    resets    = 0;
+    auto keys = m.sync_keys();
+    m.remove(0);
+    planned = plan_on_worker(keys);
+    EXPECT_FALSE(m.apply(std::move(planned)));
+    EXPECT_EQ(resets, 1);
+    ASSERT_EQ(m.rowCount(), 50);
+    EXPECT_EQ(m.at(0).uid, 98);
+
+    // changed with signals blocked, e.g. around a bulk load
+    m.resetModel(init);
+    keys = m.sync_keys();
+    {
+        QSignalBlocker blocker { m };
+        m.remove(0);
+    }
+    planned = plan_on_worker(keys);
+    EXPECT_FALSE(m.apply(std::move(planned)));
+    ASSERT_EQ(m.rowCount(), 50);
+    EXPECT_EQ(m.at(0).uid, 98);
+}
+
+TEST(Model, Lazy) {
+    meta_model::QGadgetListModel<Gadget, meta_model::QMetaListStore::Lazy> m;
+    m.set_provider(
+        [](meta_model::usize offset, meta_model::usize count, std::vector<Gadget>& out) {
+            for (auto i = offset; i < offset + count; i++) out.push_back(Gadget { (int)i, {} });
+        },
+        100,
+        4);
+    m.resetModel(1'000'000);
+    EXPECT_EQ(m.rowCount(), 1'000'000);
+    EXPECT_EQ(m.block_loads(), 0);
+
+    EXPECT_EQ(m.at(999'999).uid, 999'999);
+    for (int i = 0; i < 400; i++) {
+        ASSERT_EQ(m.at(i).uid, i);
+    }
+    EXPECT_EQ(m.block_loads(), 5);
+    EXPECT_EQ(m.cached_blocks(), 4);
+
+    // least recently used block was dropped
+    EXPECT_EQ(m.at(999'998).uid, 999'998);
+    EXPECT_EQ(m.block_loads(), 6);
+    EXPECT_EQ(m.at(350).uid, 350);
+    EXPECT_EQ(m.block_loads(), 6);
+
+    // read only
+    EXPECT_FALSE(m.removeRows(0, 1));
+    EXPECT_FALSE(m.move(0, 2, 1));
+    EXPECT_EQ(m.rowCount(), 1'000'000);
+
+    // a range loads only its block
+    auto loads = m.block_loads();
+    EXPECT_EQ(m.items(0, 3).size(), 3);
+    EXPECT_LE(m.block_loads(), loads + 1);
+
+    m.resetModel(10);
+    EXPECT_EQ(m.cached_blocks(), 0);
+    EXPECT_EQ(m.at(9).uid, 9);
+    // all rows for n = -1, as on other stores
+    EXPECT_EQ(m.items().size(), 10);
+    EXPECT_THROW(m.at(10), std::out_of_range);
+}
+
+#include "model.moc"
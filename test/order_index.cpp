@@ -0,0 +1,54 @@
+#include <random>
+#include <gtest/gtest.h>
+
+#include "meta_model/order_index.hpp"
+
+TEST(OrderIndex, Random) {
+    meta_model::detail::OrderIndex<int, std::allocator<int>> index;
+    std::vector<int>                                         order;
+
+    std::mt19937 gen(7);
+    int          next = 0;
+    for (int round = 0; round < 2000; round++) {
+        auto pick = [&gen](std::size_t n) {
+            return std::uniform_int_distribution<std::size_t>(0, n)(gen);
+        };
+        switch (gen() % 3) {
+        case 0: {
+            auto             pos = pick(order.size());
+            std::vector<int> keys;
+            for (auto n = pick(5); n > 0; n--) keys.push_back(next++);
+            index.insert(pos, keys);
+            order.insert(order.begin() + pos, keys.begin(), keys.end());
+            break;
+        }
+        case 1: {
+            if (order.empty()) break;
+            auto pos  = pick(order.size() - 1);
+            auto last = std::min(order.size(), pos + pick(3));
+            index.erase(pos, last);
+            order.erase(order.begin() + pos, order.begin() + last);
+            break;
+        }
+        case 2: {
+            if (order.empty()) break;
+            auto src   = pick(order.size() - 1);
+            auto count = 1 + pick(order.size() - src - 1);
+            auto dst   = pick(order.size());
+            if (dst >= src && dst <= src + count) break;
+            index.move(src, dst, count);
+            auto it = order.begin();
+            if (src > dst) {
+                std::rotate(it + dst, it + src, it + src + count);
+            } else {
+                std::rotate(it + src, it + src + count, it + dst);
+            }
+            break;
+        }
+        }
+        ASSERT_EQ(index.size(), order.size());
+    }
+    for (std::size_t i = 0; i < order.size(); i++) {
+        EXPECT_EQ(index.index_of(order[i]), i);
+    }
+}
@@ -0,0 +1,305 @@
+#include <chrono>
+#include <thread>
+#include <gtest/gtest.h>
+
+#include "meta_model/qgadget_list_model.hpp"
+#include "meta_model/page_loader.hpp"
+
+using namespace std::chrono_literals;
+
+struct Row {
+    Q_GADGET
+
+    Q_PROPERTY(int uid MEMBER uid)
+public:
+    int uid;
+};
+
+template<>
+struct meta_model::ItemTrait<Row> {
+    using key_type = int;
+    static auto key(const Row& r) { return r.uid; }
+};
+
+// process queued continuations until pred or timeout
+template<typename F>
+bool wait_for(F&& pred) {
+    auto end = std::chrono::steady_clock::now() + 5s;
+    while (! pred()) {
+        if (std::chrono::steady_clock::now() > end) return false;
+        QCoreApplication::processEvents();
+        std::this_thread::sleep_for(1ms);
+    }
+    return true;
+}
+
+template<meta_model::QMetaListStore Store>
+void load_pages() {
+    using model_type = meta_model::QGadgetListModel<Row, Store>;
+    auto provider    = std::make_shared<meta_model::LocalPageProvider<Row>>(
+        1000,
+        [](qint64 i) {
+            return Row { (int)i };
+        },
+        2ms);
+
+    model_type m;
+    auto       loader = new meta_model::PageLoader<model_type>(
+        &m, provider, { .page_size = 20, .prefetch = 50, .max_in_flight = 3 });
+    EXPECT_TRUE(loader->loading());
+    EXPECT_EQ(provider->fetches(), 3);
+
+    // initial prefetch
+    ASSERT_TRUE(wait_for([&] {
+        return ! loader->loading();
+    }));
+    EXPECT_EQ(m.rowCount(), 60);
+    EXPECT_TRUE(m.canFetchMore({}));
+
+    // repeated requests for rows in flight are merged
+    for (int i = 0; i < 10; i++) loader->setVisibleRow(100);
+    EXPECT_EQ(provider->fetches(), 6);
+    ASSERT_TRUE(wait_for([&] {
+        return ! loader->loading();
+    }));
+    EXPECT_EQ(m.rowCount(), 160);
+
+    // view reached the end
+    m.fetchMore({});
+    ASSERT_TRUE(wait_for([&] {
+        return ! loader->loading();
+    }));
+    EXPECT_EQ(m.rowCount(), 220);
+
+    loader->setVisibleRow(2000);
+    ASSERT_TRUE(wait_for([&] {
+        return loader->exhausted() && ! loader->loading();
+    }));
+    EXPECT_EQ(m.rowCount(), 1000);
+    EXPECT_FALSE(m.canFetchMore({}));
+    for (int i = 0; i < m.rowCount(); i++) {
+        ASSERT_EQ(m.at(i).uid, i);
+    }
+
+    loader->reload();
+    EXPECT_EQ(m.rowCount(), 0);
+    ASSERT_TRUE(wait_for([&] {
+        return ! loader->loading();
+    }));
+    EXPECT_EQ(m.rowCount(), 60);
+    delete loader;
+}
+
+TEST(PageLoader, Vector) { load_pages<meta_model::QMetaListStore::Vector>(); }
+TEST(PageLoader, Map) { load_pages<meta_model::QMetaListStore::Map>(); }
+
+TEST(PageLoader, Window) {
+    using model_type = meta_model::QGadgetListModel<Row, meta_model::QMetaListStore::Vector>;
+    auto provider    = std::make_shared<meta_model::LocalPageProvider<Row>>(1000, [](qint64 i) {
+        return Row { (int)i };
+    });
+
+    model_type m;
+    auto       loader = new meta_model::PageLoader<model_type>(
+        &m, provider, { .page_size = 20, .prefetch = 20, .max_in_flight = 2, .window = 120 });
+
+    // show rows [pos, pos + 10) and check the window around them
+    auto scroll = [&](qint64 pos) {
+        auto first = loader->firstOffset();
+        loader->setVisibleRows(pos - first, pos - first + 9);
+        ASSERT_TRUE(wait_for([&] {
+            return ! loader->loading();
+        }));
+        first = loader->firstOffset();
+        ASSERT_LE(first, pos);
+        ASSERT_GE(first + m.rowCount(), std::min<qint64>(pos + 30, 1000));
+        ASSERT_LE(m.rowCount(), 120);
+        for (int i = 0; i < m.rowCount(); i++) {
+            ASSERT_EQ(m.at(i).uid, first + i);
+        }
+    };
+
+    for (qint64 pos = 0; pos <= 990; pos += 10) scroll(pos);
+    EXPECT_TRUE(loader->exhausted());
+    EXPECT_TRUE(loader->hasPrevious());
+    EXPECT_FALSE(m.canFetchMore({}));
+    auto fetches = provider->fetches();
+
+    for (qint64 pos = 990; pos >= 0; pos -= 10) scroll(pos);
+    EXPECT_EQ(loader->firstOffset(), 0);
+    EXPECT_FALSE(loader->hasPrevious());
+    EXPECT_TRUE(m.canFetchMore({}));
+    // scrolled back rows are fetched again
+    EXPECT_GT(provider->fetches(), fetches + 40);
+    delete loader;
+}
+
+TEST(PageLoader, VisibleRowWindow) {
+    using model_type = meta_model::QGadgetListModel<Row, meta_model::QMetaListStore::Vector>;
+    auto provider    = std::make_shared<meta_model::LocalPageProvider<Row>>(1000, [](qint64 i) {
+        return Row { (int)i };
+    });
+
+    model_type m;
+    auto       loader = new meta_model::PageLoader<model_type>(
+        &m, provider, { .page_size = 20, .prefetch = 20, .max_in_flight = 2, .window = 120 });
+
+    // only the last shown row is told, as fetchMore does
+    for (qint64 pos = 0; pos <= 990; pos += 10) {
+        loader->setVisibleRow(pos - loader->firstOffset());
+        ASSERT_TRUE(wait_for([&] {
+            return ! loader->loading();
+        }));
+        auto first = loader->firstOffset();
+        ASSERT_LE(first, pos);
+        ASSERT_LE(m.rowCount(), 120);
+        for (int i = 0; i < m.rowCount(); i++) {
+            ASSERT_EQ(m.at(i).uid, first + i);
+        }
+    }
+    // rows before the window were dropped
+    EXPECT_TRUE(loader->exhausted());
+    EXPECT_GE(loader->firstOffset(), 1000 - 120);
+    delete loader;
+}
+
+TEST(PageLoader, SmallWindow) {
+    using model_type = meta_model::QGadgetListModel<Row, meta_model::QMetaListStore::Vector>;
+    auto provider    = std::make_shared<meta_model::LocalPageProvider<Row>>(1000, [](qint64 i) {
+        return Row { (int)i };
+    });
+
+    // below visible rows + 2 * prefetch, prefetch rows are kept anyway
+    model_type m;
+    auto       loader = new meta_model::PageLoader<model_type>(
+        &m, provider, { .page_size = 20, .prefetch = 20, .max_in_flight = 2, .window = 40 });
+
+    for (qint64 pos : { 0, 200, 500, 300 }) {
+        auto first = loader->firstOffset();
+        loader->setVisibleRows(pos - first, pos - first + 9);
+        // settles instead of dropping and fetching the same rows in turn
+        ASSERT_TRUE(wait_for([&] {
+            return ! loader->loading();
+        }));
+        auto fetches = provider->fetches();
+        QCoreApplication::processEvents();
+        EXPECT_EQ(provider->fetches(), fetches);
+
+        first = loader->firstOffset();
+        EXPECT_LE(first, std::max<qint64>(pos - 20, 0));
+        EXPECT_GE(first + m.rowCount(), pos + 30);
+        for (int i = 0; i < m.rowCount(); i++) {
+            ASSERT_EQ(m.at(i).uid, first + i);
+        }
+    }
+    delete loader;
+}
+
+// pages resolved by the test, in any order
+struct ManualProvider : meta_model::PageProvider<Row> {
+    struct Request {
+        qint64                                           offset;
+        qint32                                           count;
+        std::shared_ptr<QPromise<meta_model::Page<Row>>> promise;
+    };
+
+    auto fetch(qint64 offset, qint32 count) -> QFuture<meta_model::Page<Row>> override {
+        auto promise = std::make_shared<QPromise<meta_model::Page<Row>>>();
+        promise->start();
+        requests.push_back({ offset, count, promise });
+        return promise->future();
+    }
+
+    // latest request at offset
+    auto at(qint64 offset) -> Request& {
+        return *std::find_if(requests.rbegin(), requests.rend(), [offset](auto& r) {
+            return r.offset == offset;
+        });
+    }
+    void resolve(qint64 offset, qint32 n, bool has_more = true) {
+        auto&                 r = at(offset);
+        meta_model::Page<Row> page;
+        for (qint64 i = offset; i < offset + n; i++) page.items.push_back(Row { (int)i });
+        page.has_more = has_more;
+        r.promise->addResult(std::move(page));
+        r.promise->finish();
+    }
+    // finished without a result
+    void drop(qint64 offset) { at(offset).promise->finish(); }
+
+    std::vector<Request> requests;
+};
+
+TEST(PageLoader, Failure) {
+    using model_type = meta_model::QGadgetListModel<Row, meta_model::QMetaListStore::Vector>;
+    auto provider    = std::make_shared<ManualProvider>();
+
+    model_type m;
+    auto       loader = new meta_model::PageLoader<model_type>(
+        &m, provider, { .page_size = 10, .prefetch = 20, .max_in_flight = 3 });
+    ASSERT_EQ(provider->requests.size(), 3u);
+    provider->resolve(0, 10);
+    ASSERT_TRUE(wait_for([&] {
+        return m.rowCount() == 10;
+    }));
+
+    // 10 fails while 20 is in flight, later pages are dropped
+    auto late = provider->at(20).promise;
+    provider->drop(10);
+    ASSERT_TRUE(wait_for([&] {
+        return ! loader->loading();
+    }));
+    EXPECT_EQ(loader->in_flight(), 0u);
+    EXPECT_TRUE(late->isCanceled());
+    EXPECT_TRUE(m.canFetchMore({}));
+
+    provider->resolve(20, 10);
+    QCoreApplication::processEvents();
+    EXPECT_EQ(m.rowCount(), 10);
+
+    // the next fetchMore asks for the failed offset again
+    auto before = provider->requests.size();
+    m.fetchMore({});
+    ASSERT_GT(provider->requests.size(), before);
+    EXPECT_EQ(provider->requests[before].offset, 10);
+    for (auto i = before; i < provider->requests.size(); i++) {
+        provider->resolve(provider->requests[i].offset, 10);
+    }
+    ASSERT_TRUE(wait_for([&] {
+        return ! loader->loading();
+    }));
+    ASSERT_GE(m.rowCount(), 40);
+    for (int i = 0; i < m.rowCount(); i++) {
+        ASSERT_EQ(m.at(i).uid, i);
+    }
+    delete loader;
+}
+
+TEST(PageLoader, ShortPage) {
+    using model_type = meta_model::QGadgetListModel<Row, meta_model::QMetaListStore::Vector>;
+    auto provider    = std::make_shared<ManualProvider>();
+
+    model_type m;
+    auto       loader = new meta_model::PageLoader<model_type>(
+        &m, provider, { .page_size = 10, .prefetch = 10, .max_in_flight = 2 });
+    ASSERT_EQ(provider->requests.size(), 2u);
+
+    // rows [4, 10) are requested again, page 10 waits for them
+    provider->resolve(10, 10);
+    provider->resolve(0, 4);
+    ASSERT_TRUE(wait_for([&] {
+        return m.rowCount() == 4;
+    }));
+    auto rest = provider->requests.back();
+    EXPECT_EQ(rest.offset, 4);
+    EXPECT_EQ(rest.count, 6);
+
+    provider->resolve(4, 6);
+    ASSERT_TRUE(wait_for([&] {
+        return m.rowCount() == 20;
+    }));
+    for (int i = 0; i < m.rowCount(); i++) {
+        ASSERT_EQ(m.at(i).uid, i);
+    }
+    delete loader;
+}
@@ -1,12 +1,16 @@
 #include <format>
+#include <string>
+#include <thread>
 #include <gtest/gtest.h>
 
 #include "meta_model/qgadget_list_model.hpp"
+#include "meta_model/concurrent_share_store.hpp"
 
 struct Model {
     Q_GADGET
 
     Q_PROPERTY(int uid MEMBER uid)
+    Q_PROPERTY(int age MEMBER age)
 public:
     int uid;
     int age { 18 };
@@ -14,9 +18,13 @@ public:
 
 template<>
 struct meta_model::ItemTrait<Model> {
-    using key_type   = int;
-    using store_type = meta_model::ShareStore<Model>;
+    using key_type              = int;
+    using store_type            = meta_model::ShareStore<Model>;
+    static constexpr auto roles = std::tuple { &Model::uid, &Model::age };
     static auto key(meta_model::param_type<Model> m) { return m.uid; }
+    static auto equal(const Model& a, const Model& b) noexcept {
+        return a.uid == b.uid && a.age == b.age;
+    }
 };
 
 struct ListModel : meta_model::QGadgetListModel<Model, meta_model::QMetaListStore::Share> {
@@ -26,6 +34,44 @@ public:
     ListModel(QObject* p = nullptr): base_type(p) {}
 };
 
+struct Blob {
+    int         uid;
+    std::string data;
+};
+
+template<>
+struct meta_model::ItemTrait<Blob> {
+    using key_type              = int;
+    using store_type            = meta_model::ShareStore<Blob>;
+    static constexpr auto roles = std::tuple { &Blob::uid, &Blob::data };
+    static auto key(const Blob& b) { return b.uid; }
+    static auto bytes(const Blob& b) -> meta_model::usize { return sizeof(Blob) + b.data.size(); }
+};
+
+struct SharedModel {
+    Q_GADGET
+
+    Q_PROPERTY(int uid MEMBER uid)
+public:
+    int uid;
+    int age { 18 };
+};
+
+template<>
+struct meta_model::ItemTrait<SharedModel> {
+    using key_type   = int;
+    using store_type = meta_model::ConcurrentShareStore<SharedModel>;
+    static auto key(meta_model::param_type<SharedModel> m) { return m.uid; }
+};
+
+struct SharedListModel
+    : meta_model::QGadgetListModel<SharedModel, meta_model::QMetaListStore::Share> {
+    Q_OBJECT
+public:
+    using base_type = meta_model::QGadgetListModel<SharedModel, meta_model::QMetaListStore::Share>;
+    SharedListModel(QObject* p = nullptr): base_type(p) {}
+};
+
 TEST(Store, Basic) {
     meta_model::ShareStore<Model> store;
 
@@ -55,4 +101,297 @@ TEST(Store, Share) {
     EXPECT_EQ(m.at(1).age, 20);
 }
 
+TEST(Store, Notify) {
+    meta_model::ShareStore<Model> store;
+
+    ListModel m;
+    ListModel n;
+    ListModel o;
+    m.set_store(&m, store);
+    n.set_store(&n, store);
+    o.set_store(&o, store);
+    m.insert(0, std::array { Model { 1 }, Model { 2 } });
+    o.insert(0, std::array { Model { 3 } });
+
+    int changed = 0;
+    QObject::connect(&m,
+                     &QAbstractItemModel::dataChanged,
+                     &m,
+                     [&changed](const QModelIndex& a, const QModelIndex& b, const QList<int>&) {
+                         changed += b.row() - a.row() + 1;
+                     });
+    bool other_changed = false;
+    QObject::connect(&o,
+                     &QAbstractItemModel::dataChanged,
+                     &o,
+                     [&other_changed](const QModelIndex&, const QModelIndex&, const QList<int>&) {
+                         other_changed = true;
+                     });
+
+    n.insert(0, std::array { Model { 1, 10 }, Model { 2, 20 } });
+    n.insert(0, std::array { Model { 1, 11 } });
+    EXPECT_EQ(changed, 0);
+
+    store.flush();
+    EXPECT_EQ(changed, 2);
+    EXPECT_FALSE(other_changed);
+    EXPECT_EQ(m.at(0).age, 11);
+}
+
+TEST(Store, SuppressUnchanged) {
+    meta_model::ShareStore<Model> store;
+
+    ListModel m;
+    ListModel n;
+    m.set_store(&m, store);
+    n.set_store(&n, store);
+    m.insert(0, std::array { Model { 1 }, Model { 2 } });
+
+    int changed = 0;
+    QObject::connect(&m,
+                     &QAbstractItemModel::dataChanged,
+                     &m,
+                     [&changed](const QModelIndex& a, const QModelIndex& b, const QList<int>&) {
+                         changed += b.row() - a.row() + 1;
+                     });
+
+    n.insert(0, std::array { Model { 1 }, Model { 2, 20 } });
+    store.flush();
+    EXPECT_EQ(changed, 1);
+    EXPECT_EQ(store.suppressed_updates(), 1u);
+    EXPECT_EQ(m.at(1).age, 20);
+}
+
+TEST(Store, Patch) {
+    meta_model::ShareStore<Model> store;
+
+    ListModel m;
+    m.set_store(&m, store);
+    m.insert(0, std::array { Model { 1 }, Model { 2 } });
+
+    QList<int> roles;
+    int        changed = 0;
+    QObject::connect(&m,
+                     &QAbstractItemModel::dataChanged,
+                     &m,
+                     [&](const QModelIndex& a, const QModelIndex& b, const QList<int>& r) {
+                         changed += b.row() - a.row() + 1;
+                         roles = r;
+                     });
+
+    constexpr meta_model::FieldMask age = 1 << 1;
+    EXPECT_TRUE(store.store_patch(2, Model { 0, 30 }, age));
+    EXPECT_FALSE(store.store_patch(3, Model { 0, 30 }, age));
+    store.flush();
+    EXPECT_EQ(changed, 1);
+    EXPECT_EQ(roles, QList<int> { Qt::UserRole + 2 });
+    EXPECT_EQ(m.at(1).uid, 2);
+    EXPECT_EQ(m.at(1).age, 30);
+
+    // same value, nothing to notify
+    store.store_patch(2, Model { 0, 30 }, age);
+    store.flush();
+    EXPECT_EQ(changed, 1);
+    EXPECT_EQ(store.suppressed_updates(), 1u);
+
+    store.store_patch(
+        1,
+        [](Model& el) {
+            el.age = 40;
+        },
+        age);
+    store.flush();
+    EXPECT_EQ(changed, 2);
+    EXPECT_EQ(m.at(0).age, 40);
+}
+
+TEST(Store, ItemCache) {
+    meta_model::ShareStore<Model> store;
+
+    auto item = store.store_insert(Model { 1, 10 });
+    EXPECT_EQ(item->age, 10);
+    auto gen = store.store_generation();
+
+    // values don't move on growth
+    std::vector<meta_model::ShareStore<Model>::store_item_type> others;
+    for (int i = 2; i < 1000; i++) others.push_back(store.store_insert(Model { i }));
+    EXPECT_EQ(store.store_generation(), gen);
+    EXPECT_EQ(item->age, 10);
+
+    others.clear();
+    EXPECT_NE(store.store_generation(), gen);
+    EXPECT_EQ(item->age, 10);
+    EXPECT_EQ(store.size(), 1u);
+
+    auto copy = item;
+    copy      = store.store_insert(Model { 2, 20 });
+    EXPECT_EQ(copy->age, 20);
+    item = copy;
+    EXPECT_EQ(store.size(), 1u);
+    EXPECT_EQ(item->age, 20);
+}
+
+TEST(Store, Retention) {
+    meta_model::ShareStore<Model> store;
+    store.set_retention({ .max_items = 2 });
+
+    {
+        ListModel m;
+        m.set_store(&m, store);
+        m.insert(0, std::array { Model { 1 }, Model { 2 }, Model { 3 } });
+    }
+    // 1 was released first
+    EXPECT_EQ(store.size(), 2u);
+    EXPECT_EQ(store.retention_stats().evictions, 1u);
+    EXPECT_EQ(store.retention_stats().retained, 2u);
+
+    EXPECT_FALSE(store.store_item(1));
+    auto item = store.store_item(3);
+    ASSERT_TRUE(item);
+    EXPECT_EQ((*item)->uid, 3);
+    EXPECT_EQ(store.retention_stats().hits, 1u);
+    EXPECT_EQ(store.retention_stats().misses, 1u);
+    EXPECT_EQ(store.retention_stats().retained, 1u);
+
+    store.set_retention({});
+    EXPECT_EQ(store.size(), 1u);
+    item.reset();
+    EXPECT_EQ(store.size(), 0u);
+}
+
+TEST(Store, RetainedPatch) {
+    meta_model::ShareStore<Blob> store;
+    store.set_retention({ .max_items = 4 });
+    store.store_insert(Blob { 1, "abc" });
+    EXPECT_EQ(store.retention_stats().retained_bytes, sizeof(Blob) + 3);
+
+    // patching a retained entry counts its new size
+    store.store_patch(
+        1,
+        [](Blob& b) {
+            b.data.resize(10);
+        },
+        1 << 1);
+    EXPECT_EQ(store.retention_stats().retained_bytes, sizeof(Blob) + 10);
+    store.store_patch(1, Blob { 0, "" }, 1 << 1);
+    EXPECT_EQ(store.retention_stats().retained_bytes, sizeof(Blob));
+
+    auto item = store.store_item(1);
+    ASSERT_TRUE(item);
+    EXPECT_EQ(store.retention_stats().retained_bytes, 0u);
+}
+
+TEST(Store, Concurrent) {
+    using store_type = meta_model::ConcurrentShareStore<SharedModel>;
+    store_type store;
+
+    SharedListModel m;
+    m.set_store(&m, store);
+    m.insert(0, std::array { SharedModel { 1 }, SharedModel { 2 } });
+
+    int changed = 0;
+    QObject::connect(&m,
+                     &QAbstractItemModel::dataChanged,
+                     &m,
+                     [&changed](const QModelIndex& a, const QModelIndex& b, const QList<int>&) {
+                         changed += b.row() - a.row() + 1;
+                     });
+
+    constexpr int                                        threads = 4;
+    constexpr int                                        count   = 1000;
+    std::array<std::vector<store_type::store_item_type>, threads> held;
+    std::vector<std::thread>                                      workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&store, &held, t] {
+            for (int i = 0; i < count; i++) {
+                held[t].push_back(store.store_insert(SharedModel { 100 + t * count + i, t }));
+                // dropped at once, shared by all threads
+                store.store_insert(SharedModel { 10 + i % 10, t });
+                store.store_insert(SharedModel { 1, 20 + t });
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    EXPECT_EQ(changed, 0);
+    // reads don't apply queued writes
+    EXPECT_EQ(m.at(0).age, 18);
+
+    store.flush();
+    EXPECT_EQ(store.size(), 2 + threads * count);
+    EXPECT_EQ(changed, 1);
+    EXPECT_GE(m.at(0).age, 20);
+    for (int t = 0; t < threads; t++) {
+        for (auto& item : held[t]) EXPECT_EQ(item->age, t);
+    }
+
+    // released on the owner thread
+    for (auto& h : held) h.clear();
+    EXPECT_EQ(store.size(), 2);
+}
+
+TEST(Store, ConcurrentRetention) {
+    using store_type = meta_model::ConcurrentShareStore<SharedModel>;
+    store_type store;
+    store.set_retention({ .ttl = std::chrono::milliseconds(1) });
+
+    std::thread([&store] {
+        store.store_insert(SharedModel { 1 });
+        store.store_insert(SharedModel { 2 });
+    }).join();
+    auto item = store.store_item(1);
+    ASSERT_TRUE(item);
+    EXPECT_EQ(store.retention_stats().hits, 1u);
+
+    // 2 expired while retained
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_FALSE(store.store_item(2));
+    EXPECT_EQ(store.retention_stats().misses, 1u);
+    EXPECT_EQ(store.size(), 1);
+    EXPECT_EQ((*item)->uid, 1);
+}
+
+TEST(Store, Snapshot) {
+    using store_type = meta_model::ConcurrentShareStore<SharedModel>;
+    store_type store;
+
+    SharedListModel m;
+    m.set_store(&m, store);
+    m.insert(0, std::array { SharedModel { 1 }, SharedModel { 2 } });
+
+    // keys are counted in the store from the worker
+    std::optional<SharedListModel::snapshot_type> snapshot;
+    std::thread                                   worker([&snapshot, store] {
+        std::vector<SharedModel> items;
+        for (int i = 2; i < 1002; i++) items.push_back(SharedModel { i, 30 });
+        snapshot.emplace(store, std::move(items));
+    });
+    worker.join();
+
+    m.swap_snapshot(*snapshot);
+    EXPECT_EQ(m.rowCount(), 1000);
+    EXPECT_EQ(m.at(0).age, 30);
+    EXPECT_EQ(m.query_idx(1001), 999);
+    EXPECT_EQ(store.size(), 1001);
+
+    // the model is notified of the rows it took, not of the ones it gave away
+    store.flush();
+    int changed = 0;
+    QObject::connect(&m,
+                     &QAbstractItemModel::dataChanged,
+                     &m,
+                     [&changed](const QModelIndex& a, const QModelIndex& b, const QList<int>&) {
+                         changed += b.row() - a.row() + 1;
+                     });
+    store.store_insert(SharedModel { 500, 40 });
+    store.store_insert(SharedModel { 1, 40 });
+    store.flush();
+    EXPECT_EQ(changed, 1);
+    EXPECT_EQ(m.at(498).age, 40);
+
+    // old rows drop their keys with the snapshot
+    snapshot.reset();
+    EXPECT_EQ(store.size(), 1000);
+    EXPECT_EQ(m.at(0).uid, 2);
+}
+
 #include "store.moc"
\ No newline at end of file